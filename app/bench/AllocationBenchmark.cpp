@@ -0,0 +1,88 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+
+#include "Disk.h"
+
+/// \author A127B0362P silhavyj
+///
+/// A stress benchmark of the allocation of clusters.
+///
+/// Every thread keeps allocating clusters (both one at a time and a few at once)
+/// and releasing them in bulk. The throughput is measured for an increasing number
+/// of threads, so it shows how the allocation scales with the number of threads
+/// allocating clusters in parallel (e.g. when importing files in parallel).
+
+#define BENCH_DISK_FILE   "bench.dat" ///< storage of the file system used by the benchmark
+#define BENCH_DISK_SIZE   200000000   ///< size of the disk used by the benchmark (200MB)
+#define BENCH_ALLOCATIONS 500000      ///< number of clusters allocated by every thread
+#define BENCH_BATCH       64          ///< number of clusters a thread holds before it releases them
+
+/// Allocates and releases clusters until the thread has allocated #BENCH_ALLOCATIONS of them
+///
+/// \param disk the disk the clusters are allocated on
+/// \return false, if the disk has run out of free clusters. Otherwise, true.
+static bool allocateClusters(Disk *disk) {
+    std::vector<int32_t> clusters;
+    for (int32_t allocated = 0; allocated < BENCH_ALLOCATIONS;) {
+        // every other allocation claims a few clusters at once
+        if (allocated % 2 == 0) {
+            std::vector<int32_t> newClusters = disk->getFreeClusters(8);
+            if (newClusters.empty())
+                return false;
+            clusters.insert(clusters.end(), newClusters.begin(), newClusters.end());
+            allocated += newClusters.size();
+        } else {
+            int32_t cluster = disk->getFreeCluster();
+            if (cluster == disk->NULL_POINTER)
+                return false;
+            clusters.push_back(cluster);
+            allocated++;
+        }
+        if (clusters.size() >= BENCH_BATCH) {
+            disk->releaseClusters(clusters);
+            clusters.clear();
+        }
+    }
+    disk->releaseClusters(clusters);
+    return true;
+}
+
+int main() {
+    unlink(BENCH_DISK_FILE);
+    Disk disk(BENCH_DISK_FILE);
+    disk.format(BENCH_DISK_SIZE);
+
+    size_t maxThreads = std::max(4u, std::thread::hardware_concurrency());
+    double singleThreadThroughput = 0;
+    std::cout << std::left << std::setw(10) << "threads" << std::setw(22) << "clusters/s" << "speedup\n";
+    for (size_t numberOfThreads = 1; numberOfThreads <= maxThreads; numberOfThreads *= 2) {
+        std::vector<std::thread> threads;
+        std::vector<char> results(numberOfThreads, false);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < numberOfThreads; i++)
+            threads.emplace_back([&disk, &results, i]() {
+                results[i] = allocateClusters(&disk);
+            });
+        for (auto &thread : threads)
+            thread.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        for (char result : results)
+            if (result == false) {
+                std::cout << "The disk has run out of free clusters\n";
+                unlink(BENCH_DISK_FILE);
+                return 1;
+            }
+        double throughput = numberOfThreads * BENCH_ALLOCATIONS / seconds;
+        if (numberOfThreads == 1)
+            singleThreadThroughput = throughput;
+        std::cout << std::left << std::setw(10) << numberOfThreads << std::setw(22) << std::fixed << std::setprecision(0) << throughput
+                  << std::setprecision(2) << throughput / singleThreadThroughput << "x\n";
+    }
+    unlink(BENCH_DISK_FILE);
+    return 0;
+}
@@ -4,8 +4,17 @@ const std::string Disk::GB = "GB";
 const std::string Disk::MB = "MB";
 const std::string Disk::KB = "KB";
 
+std::atomic<uint64_t> Disk::nextDiskId{1};
+thread_local Disk::AllocationCacheHandle_t Disk::allocationCache;
+
+Disk::AllocationCacheHandle_t::~AllocationCacheHandle_t() {
+    if (cache != nullptr)
+        cache->abandoned = true;
+}
+
 Disk::Disk(std::string diskFileName) {
     LOG_INFO("Creating a new file system");
+    diskId = nextDiskId++;
     this->diskFileName = normalizeName(diskFileName);
 
     if (access(this->diskFileName.c_str(), F_OK) == -1)
@@ -28,25 +37,24 @@ std::string Disk::normalizeName(std::string name) {
 Disk::~Disk() {
     if (superBlock != NULL)
         delete superBlock;
-    if (bitmap != NULL)
-        delete[] bitmap;
     if (diskFile != NULL)
         fclose(diskFile);
 }
 
 void Disk::format(size_t diskSize) {
     LOG_INFO("Formatting disk");
+    ExclusiveLock_t treeGuard(treeLock);
     USER_ALERT("FORMATTING DISK (" + std::to_string(diskSize) + "B)");
 
     // check if the size is big enough to
     // at least store the superblock & the inodes
     if (diskSize < (sizeof(SuperBlock_t) + sizeof(iNodes))) {
-        USER_ALERT("CANNOT CREATE FILE");
+        USER_ALERT(Logger::STATUS_CANNOT_CREATE_FILE);
         LOG_ERR("The size of the disk is too small");
         return;
     }
     initNewFileSystem(diskSize);
-    USER_ALERT("OK");
+    USER_ALERT(Logger::STATUS_OK);
 }
 
 void Disk::initNewFileSystem(size_t diskSize) {
@@ -58,21 +66,40 @@ void Disk::initNewFileSystem(size_t diskSize) {
     ftruncate(fileno(diskFile), diskSize);
     rewind(diskFile);
 
+    defragRootId = NULL_POINTER;
+    defragRunStart = NULL_POINTER;
+    defragSourceClusters.clear();
+    clearDentryCache();
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        for (auto &name : iNodeNames)
+            name.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        workingDirectories.clear();
+    }
+    packedClusters.clear();
     initNewSuperBlock(diskSize);
     initBitmap();
     initINodes();
     initializeRootINode();
 
     saveFileSystemOnDisk();
+    mounted = true;
 }
 
 void Disk::initBitmap() {
     LOG_INFO("Creating a new bitmap");
-    if (bitmap != NULL)
-        delete[] bitmap;
-    bitmap = new bool[CLUSTER_COUNT];
-    for (int i = 0; i < CLUSTER_COUNT; i++)
-        bitmap[i] = true;
+    {
+        // the reserved clusters belong to the previous file system
+        std::lock_guard<std::mutex> lock(allocatorMutex);
+        for (auto &cache : allocationCaches) {
+            std::lock_guard<std::mutex> cacheLock(cache->mtx);
+            cache->clusters.clear();
+        }
+    }
+    setBitmapFlags(std::vector<char>(CLUSTER_COUNT, true));
 }
 
 void Disk::initNewSuperBlock(size_t diskSize) {
@@ -102,9 +129,14 @@ void Disk::initINodes() {
         iNodes[i].isFree = true;
         iNodes[i].isDirectory = false;
         iNodes[i].isSymbolicLink = false;
+        iNodes[i].isInline = false;
 
         memset(iNodes[i].direct, NULL_POINTER, sizeof(iNodes[i].direct));
         memset(iNodes[i].indirect, NULL_POINTER, sizeof(iNodes[i].indirect));
+        iNodes[i].directoryIndex = NULL_POINTER;
+        iNodes[i].packOffset = NULL_POINTER;
+        iNodes[i].subtreeSize = 0;
+        iNodes[i].subtreeClusters = 0;
     }
 }
 
@@ -119,53 +151,69 @@ void Disk::saveFileSystemOnDisk() {
 
 void Disk::saveSuperblokOnDisk() {
     LOG_INFO("Saving the superblock on the disk");
-    fseek(diskFile, 0, SEEK_SET);
-    fwrite(superBlock, sizeof(SuperBlock_t), 1, diskFile);
-    fflush(diskFile);
+    writeToDisk(superBlock, sizeof(SuperBlock_t), 1, 0);
 }
 
 void Disk::saveBitmapOnDisk() {
+    if (batch) {
+        bitmapChanged = true;
+        return;
+    }
     LOG_INFO("Saving the bitmap on the disk");
-    fseek(diskFile, superBlock->bitmapStartAddr, SEEK_SET);
-    fwrite(bitmap, sizeof(bool), CLUSTER_COUNT, diskFile);
-    fflush(diskFile);
+    std::lock_guard<std::mutex> lock(allocatorMutex);
+    std::vector<char> flags = getBitmapFlags();
+    writeToDisk(flags.data(), sizeof(bool), CLUSTER_COUNT, superBlock->bitmapStartAddr);
 }
 
 void Disk::saveINodesOnDisk() {
+    if (batch) {
+        iNodesChanged = true;
+        return;
+    }
     LOG_INFO("Saving the i-nodes on the disk");
-    fseek(diskFile, superBlock->iNodeStartAddr, SEEK_SET);
-    fwrite(&iNodes, sizeof(iNodes), 1, diskFile);
-    fflush(diskFile);
+    std::lock_guard<std::mutex> lock(metadataMutex);
+    writeToDisk(&iNodes, sizeof(iNodes), 1, superBlock->iNodeStartAddr);
 }
 
 void Disk::loadFileSystemFromDisk() {
     LOG_INFO("Loading file system from the disk");
     diskFile = fopen(this->diskFileName.c_str(), "rb+");
     loadSuperBlockFromDisk();
+
+    // the layout of the i-nodes has changed since the file system was created,
+    // so it cannot be used. The data of the user is left as it is, and the
+    // file system stays unmounted until it's formatted explicitly.
+    if (superBlock->dataStartAddr != superBlock->iNodeStartAddr + (int32_t)sizeof(iNodes)) {
+        LOG_ERR("The file system was created by an incompatible version");
+        USER_ALERT(Logger::STATUS_INCOMPATIBLE_FILE_SYSTEM);
+        fclose(diskFile);
+        diskFile = NULL;
+        initINodes();
+        return;
+    }
     loadBitmapFromDisk();
     loadINodesFromDisk();
-    currentINode = &iNodes[ROOT_INODE_ID];
+    loadPackedClusters();
+    mounted = true;
 }
 
 void Disk::loadSuperBlockFromDisk() {
     LOG_INFO("Loading a superblock from the disk");
     superBlock = new SuperBlock_t;
-    fseek(diskFile, 0, SEEK_SET);
-    fread(superBlock, sizeof(SuperBlock_t), 1, diskFile);
+    readFromDisk(superBlock, sizeof(SuperBlock_t), 1, 0);
     CLUSTER_COUNT = (superBlock->diskSize - sizeof(SuperBlock_t) - sizeof(iNodes)) / (sizeof(bool) + CLUSTER_SIZE);
 }
 
 void Disk::loadBitmapFromDisk() {
     LOG_INFO("Loading a bitmap from the disk");
-    bitmap = new bool[CLUSTER_COUNT];
-    fseek(diskFile, superBlock->bitmapStartAddr, SEEK_SET);
-    fread(bitmap, sizeof(bool), CLUSTER_COUNT, diskFile);
+    std::vector<char> flags(CLUSTER_COUNT);
+    readFromDisk(flags.data(), sizeof(bool), CLUSTER_COUNT, superBlock->bitmapStartAddr);
+    setBitmapFlags(flags);
 }
 
 void Disk::loadINodesFromDisk() {
     LOG_INFO("Loading i-nodes from the disk");
-    fseek(diskFile, superBlock->iNodeStartAddr, SEEK_SET);
-    fread(iNodes, sizeof(iNodes), 1, diskFile);
+    readFromDisk(iNodes, sizeof(iNodes), 1, superBlock->iNodeStartAddr);
 }
 
 void Disk::printFileSystem() {
@@ -176,135 +224,496 @@ void Disk::printFileSystem() {
 }
 
 std::string Disk::getCurrentPath() {
-    return getPath(currentINode);
+    SharedLock_t treeGuard(treeLock);
+    return getPath(getCurrentINode());
 }
 
 void Disk::printCurrentDirectoryItems() {
-    DirectoryItems_t *directoryItems = getDirectoryItemsFromINode(currentINode);
-    printDirectoryItems(directoryItems);
-    delete directoryItems;
+    printDirectoryItems(getCurrentINode());
 }
 
-void Disk::printDirectoryItems(const DirectoryItems_t *directoryItems) {
+void Disk::printDirectoryItems(INode_t *directoryINode) {
+    SharedLock_t treeGuard(treeLock);
+    SharedLock_t iNodeGuard(iNodeLocks[directoryINode->nodeId]);
+    if (directoryINode->isDirectory == false) {
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
+        return;
+    }
     // formated output aligned from left
-    std::cout << std::left << std::setw(10) << std::setfill(' ') << "size(B)";
-    std::cout << std::left << std::setw(7) << std::setfill(' ') << "inode";
-    std::cout << std::left << std::setw(8) << std::setfill(' ') << "p-inode\n";
-    for (int i = 0; i < (int)directoryItems->count; i++)
-        printDirectoryItem(&directoryItems->items[i]);
+    Logger::getOutput() << std::left << std::setw(10) << std::setfill(' ') << "size(B)";
+    Logger::getOutput() << std::left << std::setw(7) << std::setfill(' ') << "inode";
+    Logger::getOutput() << std::left << std::setw(8) << std::setfill(' ') << "p-inode\n";
+
+    DirectoryItem_t item;
+    DirectoryIterator it = readDirectory(directoryINode);
+    while (it.next(&item))
+        printDirectoryItem(&item);
 }
 
 void Disk::printDirectoryItem(const DirectoryItem_t *directoryItem) {
+    // the i-nodes are held in the memory, so the size and the parent cost no disk access,
+    // the type of the item is taken from the item, so only the path of a link is read
     INode_t *iNode = &iNodes[directoryItem->iNode];
 
     // formated output aligned from left
-    std::cout << std::left << std::setw(10) << std::setfill(' ') << std::to_string(iNode->size);
-    std::cout << std::left << std::setw(7) << std::setfill(' ') << iNode->nodeId;
-    std::cout << std::left << std::setw(8) << std::setfill(' ') << iNode->parentId;
-    if (iNode->isDirectory)
+    Logger::getOutput() << std::left << std::setw(10) << std::setfill(' ') << std::to_string(iNode->size);
+    Logger::getOutput() << std::left << std::setw(7) << std::setfill(' ') << iNode->nodeId;
+    Logger::getOutput() << std::left << std::setw(8) << std::setfill(' ') << iNode->parentId;
+    if (directoryItem->type == ITEM_DIRECTORY)
         // if it's a directory
-        std::cout << "[+] " << directoryItem->itemName;
+        Logger::getOutput() << "[+] " << directoryItem->itemName;
     else {
         // if it's a file
-        std::cout << "[-] " << directoryItem->itemName;
+        Logger::getOutput() << "[-] " << directoryItem->itemName;
         // if it's a symbolic link
-        if (iNode->isSymbolicLink == true) {
-            std::cout << " -> ";
-            printFileContent(iNode, false);
-        }
+        if (directoryItem->type == ITEM_SYMBOLIC_LINK)
+            Logger::getOutput() << " -> " << getPathFromSLink(iNode);
     }
-    std::cout << "\n";
+    Logger::getOutput() << "\n";
 }
 
 void Disk::printSuperblock() const {
-    std::cout << "<[SUPERBLOCK]>\n";
-    std::cout << "signature:         " << superBlock->signature << "\n";
-    std::cout << "volume descriptor: " << superBlock->volumeDescriptor << "\n";
-    std::cout << "disk size:         " << superBlock->diskSize << "\n";
-    std::cout << "cluster size:      " << superBlock->clusterSize << "\n";
-    std::cout << "cluster count:     " << superBlock->clusterCount << "\n";
-    std::cout << "bitmap address:    " << superBlock->bitmapStartAddr << "\n";
-    std::cout << "i-nodes address:   " << superBlock->iNodeStartAddr << "\n";
-    std::cout << "data address:      " << superBlock->dataStartAddr << "\n";
+    Logger::getOutput() << "<[SUPERBLOCK]>\n";
+    Logger::getOutput() << "signature:         " << superBlock->signature << "\n";
+    Logger::getOutput() << "volume descriptor: " << superBlock->volumeDescriptor << "\n";
+    Logger::getOutput() << "disk size:         " << superBlock->diskSize << "\n";
+    Logger::getOutput() << "cluster size:      " << superBlock->clusterSize << "\n";
+    Logger::getOutput() << "cluster count:     " << superBlock->clusterCount << "\n";
+    Logger::getOutput() << "bitmap address:    " << superBlock->bitmapStartAddr << "\n";
+    Logger::getOutput() << "i-nodes address:   " << superBlock->iNodeStartAddr << "\n";
+    Logger::getOutput() << "data address:      " << superBlock->dataStartAddr << "\n";
 }
 
 void Disk::printBitmap() const {
-    std::cout << "<[BITMAP]>\n";
+    Logger::getOutput() << "<[BITMAP]>\n";
     for (int i = 0; i < CLUSTER_COUNT; i++)
-        std::cout << (bitmap[i] ? "1" : "0");
-    std::cout << "\n";
+        Logger::getOutput() << (isClusterFree(i) ? "1" : "0");
+    Logger::getOutput() << "\n";
 }
 
 void Disk::printINodes() const {
     for (int i = 0; i < INODES_COUNT; i++) {
         printINode(&iNodes[i]);
-        std::cout << "\n";
+        Logger::getOutput() << "\n";
     }
 }
 
 void Disk::printINode(const INode_t *iNode) const {
-    std::cout << "<[I-NODE]>\n";
-    std::cout << "i-node id:        " << iNode->nodeId << "\n";
-    std::cout << "i-node parent id: " << iNode->parentId << "\n";
-    std::cout << "size:             " << iNode->size << "\n";
-    std::cout << "free:             " << (iNode->isFree ? "true" : "false") << "\n";
-    std::cout << "directory:        " << (iNode->isDirectory ? "true" : "false") << "\n";
-    std::cout << "slink:            " << (iNode->isSymbolicLink ? "true" : "false") << "\n";
+    Logger::getOutput() << "<[I-NODE]>\n";
+    Logger::getOutput() << "i-node id:        " << iNode->nodeId << "\n";
+    Logger::getOutput() << "i-node parent id: " << iNode->parentId << "\n";
+    Logger::getOutput() << "size:             " << iNode->size << "\n";
+    Logger::getOutput() << "free:             " << (iNode->isFree ? "true" : "false") << "\n";
+    Logger::getOutput() << "directory:        " << (iNode->isDirectory ? "true" : "false") << "\n";
+    Logger::getOutput() << "slink:            " << (iNode->isSymbolicLink ? "true" : "false") << "\n";
+    Logger::getOutput() << "inline:           " << (iNode->isInline ? "true" : "false") << "\n";
+    Logger::getOutput() << "pack offset:      " << iNode->packOffset << "\n";
+    Logger::getOutput() << "subtree size:     " << iNode->subtreeSize << "\n";
+    Logger::getOutput() << "subtree clusters: " << iNode->subtreeClusters << "\n";
     for (int i = 0; i < NUM_OF_DIRECT_POINTERS; i++)
-        std::cout << "direct (" << (i+1) << "):       " << iNode->direct[i] << "\n";
+        Logger::getOutput() << "direct (" << (i+1) << "):       " << iNode->direct[i] << "\n";
     for (int i = 0; i < NUM_OF_INDIRECT_POINTERS; i++)
-        std::cout << "indirect (" << (i+1) << "):     " << iNode->indirect[i] << "\n";
+        Logger::getOutput() << "indirect (" << (i+1) << "):     " << iNode->indirect[i] << "\n";
 }
 
 void Disk::initializeRootINode() {
     LOG_INFO("Initializing a new root i-node");
-    currentINode = &iNodes[ROOT_INODE_ID];
+    INode_t *rootINode = &iNodes[ROOT_INODE_ID];
 
-    currentINode->isFree = false;
-    currentINode->isDirectory = true;
-    currentINode->parentId = currentINode->nodeId;
+    rootINode->isFree = false;
+    rootINode->isDirectory = true;
+    rootINode->parentId = rootINode->nodeId;
 }
 
-int32_t Disk::getFreeCluster() {
-    for (int32_t i = 0; i < CLUSTER_COUNT; i++)
-        if (bitmap[i] == true) {
-            bitmap[i] = false;
-            return i;
+int32_t Disk::getFreeCluster(const INode_t *iNode) {
+    std::vector<int32_t> clusters = getFreeClusters(1, iNode);
+    if (clusters.empty())
+        return NULL_POINTER;
+    return clusters[0];
+}
+
+std::vector<int32_t> Disk::getFreeClusters(int32_t n, const INode_t *iNode) {
+    if (n <= 0)
+        return std::vector<int32_t>();
+    int32_t group = getAllocationGroupOfClusters(iNode);
+    if (n > ALLOCATION_CACHE_LEN)
+        return claimClusters(n, group);
+
+    AllocationCache_t *cache = getAllocationCache();
+    std::unique_lock<std::mutex> lock(cache->mtx);
+    if ((int32_t)cache->clusters.size() != allocationGroupCount)
+        cache->clusters.resize(allocationGroupCount);
+    std::vector<int32_t> &cachedClusters = cache->clusters[group];
+    if ((int32_t)cachedClusters.size() < n)
+        claimFreeClusters(ALLOCATION_CACHE_LEN - cachedClusters.size(), group, cachedClusters);
+    if ((int32_t)cachedClusters.size() < n) {
+        // the rest of the free clusters might be
+        // reserved in the caches of other threads
+        lock.unlock();
+        return claimClusters(n, group);
+    }
+    std::vector<int32_t> clusters(cachedClusters.begin(), cachedClusters.begin() + n);
+    cachedClusters.erase(cachedClusters.begin(), cachedClusters.begin() + n);
+    return clusters;
+}
+
+void Disk::releaseClusters(const std::vector<int32_t> &clusters) {
+    for (int32_t cluster : clusters)
+        setClusterFree(cluster, true);
+}
+
+void Disk::returnCachedClusters() {
+    LOG_INFO("Returning the clusters reserved by the threads");
+    std::lock_guard<std::mutex> lock(allocatorMutex);
+    for (auto it = allocationCaches.begin(); it != allocationCaches.end();) {
+        {
+            std::lock_guard<std::mutex> cacheLock((*it)->mtx);
+            for (auto &clusters : (*it)->clusters)
+                releaseClusters(clusters);
+            (*it)->clusters.clear();
         }
-    return NULL_POINTER;
+        if ((*it)->abandoned)
+            it = allocationCaches.erase(it);
+        else it++;
+    }
+}
+
+bool Disk::isClusterFree(int32_t cluster) const {
+    return (bitmap[cluster / 64].load() >> (cluster % 64)) & 1;
+}
+
+void Disk::setClusterFree(int32_t cluster, bool free) {
+    uint64_t bit = (uint64_t)1 << (cluster % 64);
+    AllocationGroup_t &group = allocationGroups[getAllocationGroupOfCluster(cluster)];
+    if (free) {
+        if ((bitmap[cluster / 64].fetch_or(bit) & bit) == 0)
+            group.freeClusters++;
+    }
+    else if ((bitmap[cluster / 64].fetch_and(~bit) & bit) != 0)
+        group.freeClusters--;
+}
+
+void Disk::claimFreeClusters(int32_t n, int32_t group, std::vector<int32_t> &clusters) {
+    // the group given as a parameter goes first, then the following ones
+    for (int32_t i = 0; i < allocationGroupCount && n > 0; i++) {
+        AllocationGroup_t &allocationGroup = allocationGroups[(group + i) % allocationGroupCount];
+        if (allocationGroup.freeClusters <= 0)
+            continue;
+        int32_t words = allocationGroup.lastWord - allocationGroup.firstWord;
+        int32_t first = allocationGroup.nextFreeWord.load();
+        for (int32_t j = 0; j < words && n > 0; j++) {
+            int32_t index = allocationGroup.firstWord + (first + j) % words;
+            uint64_t word = bitmap[index].load();
+            uint64_t claimed = 0;
+            while (word != 0) {
+                // take the lowest free clusters of the word, so the clusters
+                // of a file tend to follow each other
+                claimed = 0;
+                uint64_t remaining = word;
+                for (int32_t count = 0; count < n && remaining != 0; count++) {
+                    claimed |= remaining & (~remaining + 1);
+                    remaining &= remaining - 1;
+                }
+                // if another thread has changed the word in the meantime, the word is re-read
+                if (bitmap[index].compare_exchange_weak(word, word & ~claimed))
+                    break;
+                claimed = 0;
+            }
+            allocationGroup.freeClusters -= __builtin_popcountll(claimed);
+            for (; claimed != 0; claimed &= claimed - 1) {
+                clusters.push_back(index * 64 + __builtin_ctzll(claimed));
+                n--;
+            }
+            if (n == 0)
+                allocationGroup.nextFreeWord = index - allocationGroup.firstWord;
+        }
+    }
+}
+
+std::vector<int32_t> Disk::claimClusters(int32_t n, int32_t group) {
+    std::vector<int32_t> clusters;
+    claimFreeClusters(n, group, clusters);
+    if ((int32_t)clusters.size() < n) {
+        returnCachedClusters();
+        claimFreeClusters(n - clusters.size(), group, clusters);
+    }
+    if ((int32_t)clusters.size() < n) {
+        releaseClusters(clusters);
+        return std::vector<int32_t>();
+    }
+    return clusters;
+}
+
+Disk::AllocationCache_t *Disk::getAllocationCache() {
+    if (allocationCache.diskId == diskId)
+        return allocationCache.cache.get();
+
+    // the cache of another disk (if there's any) is left
+    // behind to be returned by its disk
+    if (allocationCache.cache != nullptr)
+        allocationCache.cache->abandoned = true;
+    allocationCache.cache = std::make_shared<AllocationCache_t>();
+    allocationCache.diskId = diskId;
+    std::lock_guard<std::mutex> lock(allocatorMutex);
+    allocationCaches.push_back(allocationCache.cache);
+    return allocationCache.cache.get();
+}
+
+std::vector<char> Disk::getBitmapFlags() {
+    std::vector<char> flags(CLUSTER_COUNT);
+    for (int32_t i = 0; i < CLUSTER_COUNT; i++)
+        flags[i] = isClusterFree(i);
+    for (auto &cache : allocationCaches) {
+        std::lock_guard<std::mutex> cacheLock(cache->mtx);
+        for (auto &clusters : cache->clusters)
+            for (int32_t cluster : clusters)
+                flags[cluster] = true;
+    }
+    return flags;
+}
+
+void Disk::setBitmapFlags(const std::vector<char> &flags) {
+    bitmapWords = (CLUSTER_COUNT + 63) / 64;
+    bitmap.reset(new std::atomic<uint64_t>[bitmapWords]);
+    for (int32_t i = 0; i < bitmapWords; i++)
+        bitmap[i] = 0;
+    initAllocationGroups();
+    for (int32_t i = 0; i < CLUSTER_COUNT; i++)
+        if (flags[i])
+            setClusterFree(i, true);
+}
+
+void Disk::initAllocationGroups() {
+    LOG_INFO("Splitting the clusters and the i-nodes into allocation groups");
+    // every group has at least one i-node
+    allocationGroupCount = (CLUSTER_COUNT + ALLOCATION_GROUP_LEN - 1) / ALLOCATION_GROUP_LEN;
+    allocationGroupCount = std::max(1, std::min(allocationGroupCount, (int32_t)INODES_COUNT));
+    allocationGroups.reset(new AllocationGroup_t[allocationGroupCount]);
+    for (int32_t i = 0; i < allocationGroupCount; i++) {
+        allocationGroups[i].firstWord = i * (ALLOCATION_GROUP_LEN / 64);
+        allocationGroups[i].lastWord = std::min(bitmapWords, (i + 1) * (ALLOCATION_GROUP_LEN / 64));
+        allocationGroups[i].firstINode = i * INODES_COUNT / allocationGroupCount;
+        allocationGroups[i].lastINode = (i + 1) * INODES_COUNT / allocationGroupCount;
+    }
+    // the clusters that do not fit into the groups (if there are more groups
+    // than i-nodes) are added to the last group
+    allocationGroups[allocationGroupCount - 1].lastWord = bitmapWords;
+}
+
+int32_t Disk::getAllocationGroupOfINode(int32_t iNodeId) const {
+    return ((iNodeId + 1) * allocationGroupCount - 1) / INODES_COUNT;
+}
+
+int32_t Disk::getAllocationGroupOfCluster(int32_t cluster) const {
+    return std::min(cluster / ALLOCATION_GROUP_LEN, allocationGroupCount - 1);
+}
+
+int32_t Disk::getAllocationGroupOfClusters(const INode_t *iNode) const {
+    if (iNode == NULL)
+        return 0;
+    if (iNode->isDirectory == false && iNode->parentId >= 0 && iNode->parentId < INODES_COUNT)
+        return getAllocationGroupOfINode(iNode->parentId);
+    return getAllocationGroupOfINode(iNode->nodeId);
+}
+
+int32_t Disk::getAllocationGroupOfNewINode(const INode_t *parentINode, bool isDirectory) const {
+    if (parentINode == NULL)
+        return 0;
+    if (isDirectory == false || parentINode->nodeId != ROOT_INODE_ID)
+        return getAllocationGroupOfINode(parentINode->nodeId);
+
+    // the directories within the root directory are spread out
+    // over the groups, so their trees have space to grow
+    int32_t group = 0;
+    for (int32_t i = 1; i < allocationGroupCount; i++)
+        if (allocationGroups[i].freeClusters > allocationGroups[group].freeClusters)
+            group = i;
+    return group;
 }
 
 void Disk::saveRootDirectoryOnDisk() {
     LOG_INFO("Saving the root directory on the disk");
-    auto rootDir = std::unique_ptr<DirectoryItems_t>(new DirectoryItems_t(currentINode->nodeId, currentINode->nodeId));
-    currentINode->size = sizeof(size_t) + rootDir->count * sizeof(DirectoryItem_t);
-    if (addDirectClustersToINode(iNodes) == false)
+    INode_t *rootINode = &iNodes[ROOT_INODE_ID];
+    auto rootDir = std::unique_ptr<DirectoryItems_t>(new DirectoryItems_t(rootINode->nodeId, rootINode->nodeId));
+    if (resizeDirectory(rootINode, rootDir->count) == false)
         return;
-    saveDirectoryItemsOnDisk(currentINode, rootDir.get());
+    saveDirectoryItemsOnDisk(rootINode, rootDir.get());
 }
 
-bool Disk::isThereAtLeastNFreeClusters(int32_t n) {
-    LOG_INFO("Checking if there's at least n free clusters in the file system");
-    int32_t freeClusters = 0;
-    for (int i = 0; i < CLUSTER_COUNT; i++)
-        if ((freeClusters += bitmap[i]) == n)
-            return true;
-    return false;
+int32_t Disk::getClusterOfINode(INode_t *iNode, int32_t index) {
+    int32_t numberOfPointersInCluster = superBlock->clusterSize / sizeof(int32_t);
+    int32_t cluster;
+    if (index < NUM_OF_DIRECT_POINTERS)
+        return iNode->direct[index];
+
+    index -= NUM_OF_DIRECT_POINTERS;
+    if (index < numberOfPointersInCluster) {
+        readFromDisk(&cluster, sizeof(int32_t), 1, dataOffset(iNode->indirect[0]) + index * sizeof(int32_t));
+        return cluster;
+    }
+    index -= numberOfPointersInCluster;
+    int32_t middleCluster;
+    readFromDisk(&middleCluster, sizeof(int32_t), 1, dataOffset(iNode->indirect[1]) + (index / numberOfPointersInCluster) * sizeof(int32_t));
+    readFromDisk(&cluster, sizeof(int32_t), 1, dataOffset(middleCluster) + (index % numberOfPointersInCluster) * sizeof(int32_t));
+    return cluster;
 }
 
-bool Disk::addDirectClustersToINode(INode_t *iNode) {
-    LOG_INFO("Adding new direct clusters to the i-node");
-    int32_t numberOfClusters = getNumberOfClustersNeeded(iNode->size);
-    if (numberOfClusters > NUM_OF_DIRECT_POINTERS) {
-        LOG_ERR("It requires to use indirect pointers as well");
+bool Disk::addClusterToINode(INode_t *iNode, int32_t index) {
+    LOG_INFO("Adding a new cluster to the i-node");
+    int32_t numberOfPointersInCluster = superBlock->clusterSize / sizeof(int32_t);
+    int32_t middleIndex = index - NUM_OF_DIRECT_POINTERS - numberOfPointersInCluster;
+
+    if (middleIndex >= numberOfPointersInCluster * numberOfPointersInCluster) {
+        LOG_ERR("The i-node is too big for this file system");
         return false;
     }
-    if (isThereAtLeastNFreeClusters(NUM_OF_DIRECT_POINTERS) == false) {
+    // the cluster itself + the indirect/middle clusters
+    // that are needed when the cluster is the first one in them
+    int32_t numberOfClustersNeeded = 1;
+    if (index == NUM_OF_DIRECT_POINTERS || middleIndex == 0)
+        numberOfClustersNeeded++;
+    if (middleIndex >= 0 && middleIndex % numberOfPointersInCluster == 0)
+        numberOfClustersNeeded++;
+    std::vector<int32_t> newClusters = getFreeClusters(numberOfClustersNeeded, iNode);
+    if ((int32_t)newClusters.size() != numberOfClustersNeeded) {
         LOG_ERR("There's not enough free clusters in the file system");
         return false;
     }
-    for (int i = 0; i < NUM_OF_DIRECT_POINTERS; i++)
-        iNode->direct[i] = getFreeCluster();
+    int32_t cluster = newClusters[0];
+    if (index < NUM_OF_DIRECT_POINTERS) {
+        iNode->direct[index] = cluster;
+        return true;
+    }
+    off_t pointerOffset;
+    if (middleIndex < 0) {
+        LOG_INFO("Adding the cluster into the first indirect cluster");
+        if (index == NUM_OF_DIRECT_POINTERS)
+            iNode->indirect[0] = newClusters[1];
+        pointerOffset = dataOffset(iNode->indirect[0]) + (index - NUM_OF_DIRECT_POINTERS) * sizeof(int32_t);
+    } else {
+        LOG_INFO("Adding the cluster into a middle cluster of the second indirect cluster");
+        if (middleIndex == 0)
+            iNode->indirect[1] = newClusters[1];
+        int32_t middleCluster;
+        off_t middleOffset = dataOffset(iNode->indirect[1]) + (middleIndex / numberOfPointersInCluster) * sizeof(int32_t);
+        if (middleIndex % numberOfPointersInCluster == 0) {
+            middleCluster = newClusters.back();
+            writeToDisk(&middleCluster, sizeof(int32_t), 1, middleOffset);
+        } else readFromDisk(&middleCluster, sizeof(int32_t), 1, middleOffset);
+        pointerOffset = dataOffset(middleCluster) + (middleIndex % numberOfPointersInCluster) * sizeof(int32_t);
+    }
+    writeToDisk(&cluster, sizeof(int32_t), 1, pointerOffset);
+    return true;
+}
+
+void Disk::removeClusterFromINode(INode_t *iNode, int32_t index) {
+    LOG_INFO("Removing the last cluster of the i-node");
+    int32_t numberOfPointersInCluster = superBlock->clusterSize / sizeof(int32_t);
+    int32_t middleIndex = index - NUM_OF_DIRECT_POINTERS - numberOfPointersInCluster;
+
+    std::vector<int32_t> clusters(1, getClusterOfINode(iNode, index));
+    if (index < NUM_OF_DIRECT_POINTERS) {
+        iNode->direct[index] = NULL_POINTER;
+        releaseClusters(clusters);
+        return;
+    }
+    // release the indirect/middle clusters
+    // if the cluster was the only one in them
+    if (index == NUM_OF_DIRECT_POINTERS) {
+        clusters.push_back(iNode->indirect[0]);
+        iNode->indirect[0] = NULL_POINTER;
+    }
+    if (middleIndex >= 0 && middleIndex % numberOfPointersInCluster == 0) {
+        int32_t middleCluster;
+        readFromDisk(&middleCluster, sizeof(int32_t), 1, dataOffset(iNode->indirect[1]) + (middleIndex / numberOfPointersInCluster) * sizeof(int32_t));
+        clusters.push_back(middleCluster);
+    }
+    if (middleIndex == 0) {
+        clusters.push_back(iNode->indirect[1]);
+        iNode->indirect[1] = NULL_POINTER;
+    }
+    releaseClusters(clusters);
+}
+
+int32_t Disk::getNumberOfClustersOfINode(INode_t *iNode) const {
+    if (iNode->isInline)
+        return 0;
+    if (iNode->isDirectory == false || iNode->size <= 0)
+        return getNumberOfClustersNeeded(iNode->size);
+
+    // an item of a directory never spans two clusters, so the number
+    // of clusters is given by the number of items rather than the size
+    int32_t count = (iNode->size - sizeof(size_t)) / sizeof(DirectoryItem_t);
+    int32_t numberOfItemsInCluster = getNumberOfItemsInCluster();
+    return std::max(1, (count + numberOfItemsInCluster - 1) / numberOfItemsInCluster);
+}
+
+int32_t Disk::getNumberOfOccupiedClusters(INode_t *iNode) const {
+    if (iNode->packOffset != NULL_POINTER)
+        return 0;
+    int32_t numberOfClusters = getNumberOfClustersOfINode(iNode);
+    int32_t numberOfPointersInCluster = superBlock->clusterSize / sizeof(int32_t);
+    int32_t occupiedClusters = numberOfClusters;
+
+    // the first indirect cluster, the second indirect cluster and the middle clusters
+    if (numberOfClusters > NUM_OF_DIRECT_POINTERS)
+        occupiedClusters++;
+    int32_t remainingClusters = numberOfClusters - NUM_OF_DIRECT_POINTERS - numberOfPointersInCluster;
+    if (remainingClusters > 0)
+        occupiedClusters += 1 + (remainingClusters + numberOfPointersInCluster - 1) / numberOfPointersInCluster;
+    return occupiedClusters;
+}
+
+void Disk::addToSubtreeUsage(INode_t *directoryINode, int64_t size, int64_t clusters) {
+    std::lock_guard<std::mutex> lock(metadataMutex);
+
+    // the number of steps is limited in case
+    // the parent ids happen to form a cycle
+    for (int i = 0; i < INODES_COUNT; i++) {
+        directoryINode->subtreeSize += size;
+        directoryINode->subtreeClusters += clusters;
+        if (directoryINode->parentId == directoryINode->nodeId || directoryINode->parentId < 0 || directoryINode->parentId >= INODES_COUNT)
+            return;
+        directoryINode = &iNodes[directoryINode->parentId];
+    }
+}
+
+void Disk::updateSubtreeUsage(INode_t *directoryINode, INode_t *iNode, bool linked) {
+    int64_t size = iNode->isDirectory ? iNode->subtreeSize : iNode->size;
+    int64_t clusters = iNode->isDirectory ? iNode->subtreeClusters : getNumberOfOccupiedClusters(iNode);
+    if (linked)
+        addToSubtreeUsage(directoryINode, size, clusters);
+    else addToSubtreeUsage(directoryINode, -size, -clusters);
+}
+
+bool Disk::resizeDirectory(INode_t *directoryINode, size_t count) {
+    LOG_INFO("Resizing the directory");
+    int32_t oldSize = directoryINode->size;
+    int32_t oldOccupiedClusters = getNumberOfOccupiedClusters(directoryINode);
+    int32_t oldNumberOfClusters = getNumberOfClustersOfINode(directoryINode);
+    directoryINode->size = sizeof(size_t) + count * sizeof(DirectoryItem_t);
+    int32_t newNumberOfClusters = getNumberOfClustersOfINode(directoryINode);
+
+    LOG_INFO("Adding clusters the new items are going to be stored in");
+    for (int32_t i = oldNumberOfClusters; i < newNumberOfClusters; i++) {
+        // directories created by older versions have
+        // all their direct clusters allocated up front
+        if (i < NUM_OF_DIRECT_POINTERS && directoryINode->direct[i] != NULL_POINTER)
+            continue;
+        if (addClusterToINode(directoryINode, i) == false) {
+            while (--i >= oldNumberOfClusters)
+                removeClusterFromINode(directoryINode, i);
+            directoryINode->size = oldSize;
+            return false;
+        }
+    }
+    LOG_INFO("Releasing clusters that are not needed anymore");
+    for (int32_t i = oldNumberOfClusters - 1; i >= newNumberOfClusters && i > 0; i--)
+        removeClusterFromINode(directoryINode, i);
+
+    int32_t occupiedClusters = getNumberOfOccupiedClusters(directoryINode);
+    if (occupiedClusters != oldOccupiedClusters)
+        addToSubtreeUsage(directoryINode, 0, occupiedClusters - oldOccupiedClusters);
     return true;
 }
 
@@ -316,6 +725,8 @@ Disk::DirectoryItems_t::DirectoryItems_t(int32_t iNodeId, int32_t iNodeParentId)
     strcpy(items[1].itemName, "..");
     items[0].iNode = iNodeId;
     items[1].iNode = iNodeParentId;
+    items[0].type = ITEM_DIRECTORY;
+    items[1].type = ITEM_DIRECTORY;
 }
 
 Disk::DirectoryItems_t::~DirectoryItems_t() {
@@ -352,36 +763,20 @@ void Disk::saveDirectoryItemsOnDisk(INode_t *iNode, DirectoryItems_t *directoryI
         return;
     }
 
-    int32_t numberOfClustersNeeded = getNumberOfClustersNeeded(iNode->size);
-    int32_t numberOfItemsInCluster = (superBlock->clusterSize - sizeof(size_t)) / sizeof(DirectoryItem_t);
-
-    if (numberOfClustersNeeded > NUM_OF_DIRECT_POINTERS) {
-        LOG_ERR("It requires to use indirect pointers to store this directory as well");
+    if (iNode->size != (int32_t)(sizeof(size_t) + directoryItems->count * sizeof(DirectoryItem_t))) {
+        LOG_ERR("The size of the directory does not match the number of items");
         return;
     }
     LOG_INFO("Storing the number of directory items at the first position in the first cluster");
-    fseek(diskFile, dataOffset(iNode->direct[0]), SEEK_SET);
-    fwrite(&directoryItems->count, sizeof(size_t), 1, diskFile);
-    fflush(diskFile);
-
-    size_t index = 0;
-    size_t count = 0;
+    writeToDisk(&directoryItems->count, sizeof(size_t), 1, dataOffset(iNode->direct[0]));
 
     LOG_INFO("Storing the directory items themselves");
-    DirectoryItem_t *buff = new DirectoryItem_t[numberOfItemsInCluster];
-    for (int32_t i = 0; i < numberOfClustersNeeded; i++) {
-        fseek(diskFile, dataOffset(iNode->direct[i]) + (i == 0 ? sizeof(size_t) : 0), SEEK_SET);
-        for (int32_t j = 0; j < numberOfItemsInCluster; j++) {
-            buff[j] = directoryItems->items[index++];
-            count++;
-            if (index == directoryItems->count)
-                break;
-        }
-        fwrite(buff, sizeof(DirectoryItem_t), count, diskFile);
-        count = 0;
+    size_t numberOfItemsInCluster = getNumberOfItemsInCluster();
+    for (size_t index = 0; index < directoryItems->count;) {
+        size_t count = std::min(numberOfItemsInCluster - index % numberOfItemsInCluster, directoryItems->count - index);
+        writeToDisk(&directoryItems->items[index], sizeof(DirectoryItem_t), count, getDirectoryItemOffset(iNode, index));
+        index += count;
     }
-    fflush(diskFile);
-    delete[] buff;
 }
 
 Disk::DirectoryItems_t * Disk::getDirectoryItemsFromINode(INode_t *iNode) {
@@ -390,260 +785,831 @@ Disk::DirectoryItems_t * Disk::getDirectoryItemsFromINode(INode_t *iNode) {
         LOG_ERR("The i-node is NULL");
         return NULL;
     }
+    DirectoryItems_t *directoryItems = new DirectoryItems_t();
+    directoryItems->count = (iNode->size - sizeof(size_t)) / sizeof(DirectoryItem_t);
+    directoryItems->items = new DirectoryItem_t[directoryItems->count];
 
-    int32_t numberOfClustersNeeded = getNumberOfClustersNeeded(iNode->size);
-    int32_t numberOfEntriesInCluster = (superBlock->clusterSize - sizeof(size_t)) / sizeof(DirectoryItem_t);
+    LOG_INFO("Loading the items themselves");
+    DirectoryIterator it = readDirectory(iNode);
+    for (size_t i = 0; i < directoryItems->count && it.next(&directoryItems->items[i]); i++)
+        ;
+    return directoryItems;
+}
 
-    if (numberOfClustersNeeded > NUM_OF_DIRECT_POINTERS) {
-        LOG_ERR("To load this directory items requires to use indirect clusters as well");
-        return NULL;
+Disk::DirectoryIterator Disk::readDirectory(INode_t *directoryINode) {
+    return DirectoryIterator(this, directoryINode);
+}
+
+Disk::DirectoryIterator::DirectoryIterator(Disk *disk, INode_t *directoryINode) : disk(disk), directoryINode(directoryINode) {
+    count = (directoryINode->size - sizeof(size_t)) / sizeof(DirectoryItem_t);
+}
+
+bool Disk::DirectoryIterator::next(DirectoryItem_t *item) {
+    if (position >= count)
+        return false;
+    if (index == items.size()) {
+        // read the rest of the cluster the next item is stored in
+        int32_t numberOfItemsInCluster = disk->getNumberOfItemsInCluster();
+        int32_t itemsInCluster = std::min(numberOfItemsInCluster - position % numberOfItemsInCluster, count - position);
+        items.resize(itemsInCluster);
+        disk->readFromDisk(items.data(), sizeof(DirectoryItem_t), itemsInCluster, disk->getDirectoryItemOffset(directoryINode, position));
+        index = 0;
+    }
+    *item = items[index++];
+    position++;
+    return true;
+}
+
+int32_t Disk::DirectoryIterator::getPosition() const {
+    return position - 1;
+}
+
+Disk::FileReader::FileReader(Disk *disk, INode_t *iNode) : disk(disk), iNode(iNode) {
+    numberOfClusters = disk->getNumberOfClustersOfINode(iNode);
+    pointersCluster = disk->NULL_POINTER;
+    if (numberOfClusters <= window) {
+        // there's nothing to be read ahead
+        if (numberOfClusters > 0)
+            windows.push_back(readWindow(0, numberOfClusters));
+        finished = true;
+        return;
     }
-    DirectoryItems_t *directoryItems = new DirectoryItems_t();
+    prefetcher = std::thread(&FileReader::prefetch, this);
+}
 
-    LOG_INFO("Loading the number of items");
-    fseek(diskFile, dataOffset(iNode->direct[0]), SEEK_SET);
-    fread(&directoryItems->count, sizeof(size_t), 1, diskFile);
+Disk::FileReader::~FileReader() {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        closing = true;
+    }
+    windowTaken.notify_one();
+    if (prefetcher.joinable())
+        prefetcher.join();
+}
 
-    directoryItems->items = new DirectoryItem_t[directoryItems->count];
-    DirectoryItem_t *buff = new DirectoryItem_t[numberOfEntriesInCluster];
+bool Disk::FileReader::next(std::string &data) {
+    std::unique_lock<std::mutex> lock(mtx);
+    windowRead.wait(lock, [this]() {
+        return finished || windows.empty() == false;
+    });
+    if (windows.empty())
+        return false;
+    data = std::move(windows.front());
+    windows.pop_front();
+    windowTaken.notify_one();
+    return true;
+}
 
-    LOG_INFO("Loading the items themselves");
-    size_t index = 0;
+void Disk::FileReader::prefetch() {
+    while (nextIndex < numberOfClusters) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            windowTaken.wait(lock, [this]() {
+                return closing || windows.size() < READ_AHEAD_WINDOWS;
+            });
+            if (closing)
+                return;
+        }
+        int32_t count = std::min(window, numberOfClusters - nextIndex);
+        std::string data = readWindow(nextIndex, count);
+        nextIndex += count;
+        window = std::min(READ_AHEAD_MAX_LEN, window * 2);
+
+        std::unique_lock<std::mutex> lock(mtx);
+        windows.push_back(std::move(data));
+        finished = nextIndex >= numberOfClusters;
+        windowRead.notify_one();
+    }
+}
 
-    for (int32_t i = 0; i < numberOfClustersNeeded; i++) {
-        fseek(diskFile, dataOffset(iNode->direct[i]) + (i == 0 ? sizeof(size_t) : 0), SEEK_SET);
-        fread(buff, sizeof(DirectoryItem_t), numberOfEntriesInCluster, diskFile);
+std::string Disk::FileReader::readWindow(int32_t first, int32_t count) {
+    int32_t clusterSize = disk->superBlock->clusterSize;
+    int64_t size = std::min((int64_t)count * clusterSize, (int64_t)iNode->size - (int64_t)first * clusterSize);
+    std::string data(size, '\0');
+    std::vector<int32_t> clusters(count);
+    for (int32_t i = 0; i < count; i++)
+        clusters[i] = getCluster(first + i);
+
+    // a run of clusters following each other is read at once
+    for (int32_t i = 0; i < count;) {
+        int32_t last = i + 1;
+        while (last < count && clusters[last] == clusters[last - 1] + 1)
+            last++;
+        int64_t length = std::min((int64_t)(last - i) * clusterSize, size - (int64_t)i * clusterSize);
+        disk->readFromDisk(&data[i * clusterSize], sizeof(char), length, disk->dataOffset(clusters[i]));
+        i = last;
+    }
+    return data;
+}
+
+int32_t Disk::FileReader::getCluster(int32_t index) {
+    if (index < NUM_OF_DIRECT_POINTERS)
+        return iNode->direct[index];
+
+    int32_t numberOfPointersInCluster = disk->superBlock->clusterSize / sizeof(int32_t);
+    int32_t cluster;
+    int32_t nextCluster = disk->NULL_POINTER;
+    index -= NUM_OF_DIRECT_POINTERS;
+    if (index < numberOfPointersInCluster) {
+        cluster = iNode->indirect[0];
+        if (numberOfClusters > NUM_OF_DIRECT_POINTERS + numberOfPointersInCluster)
+            nextCluster = iNode->indirect[1];
+    } else {
+        index -= numberOfPointersInCluster;
+        if (middlePointers.empty())
+            readPointers(iNode->indirect[1], middlePointers);
+        int32_t middleIndex = index / numberOfPointersInCluster;
+        cluster = middlePointers[middleIndex];
+        if ((middleIndex + 1) * numberOfPointersInCluster < numberOfClusters - NUM_OF_DIRECT_POINTERS - numberOfPointersInCluster)
+            nextCluster = middlePointers[middleIndex + 1];
+        index %= numberOfPointersInCluster;
+    }
+    if (cluster != pointersCluster) {
+        readPointers(cluster, pointers);
+        pointersCluster = cluster;
+
+        // the reader is going to need the next pointer cluster soon
+        if (nextCluster != disk->NULL_POINTER)
+            posix_fadvise(fileno(disk->diskFile), disk->dataOffset(nextCluster), disk->superBlock->clusterSize, POSIX_FADV_WILLNEED);
+    }
+    return pointers[index];
+}
+
+void Disk::FileReader::readPointers(int32_t cluster, std::vector<int32_t> &pointers) {
+    pointers.resize(disk->superBlock->clusterSize / sizeof(int32_t));
+    disk->readFromDisk(pointers.data(), sizeof(int32_t), pointers.size(), disk->dataOffset(cluster));
+}
+
+Disk::INode_t *Disk::getFreeINode(const INode_t *parentINode, bool isDirectory) {
+    int32_t group = getAllocationGroupOfNewINode(parentINode, isDirectory);
+    for (int32_t i = 0; i < allocationGroupCount; i++) {
+        AllocationGroup_t &allocationGroup = allocationGroups[(group + i) % allocationGroupCount];
+        std::lock_guard<std::mutex> lock(allocationGroup.mtx);
+        for (int32_t j = allocationGroup.firstINode; j < allocationGroup.lastINode; j++)
+            if (iNodes[j].isFree == true) {
+                iNodes[j].isFree = false;
+                if (isDirectory == false && parentINode != NULL)
+                    iNodes[j].parentId = parentINode->nodeId;
+                return &iNodes[j];
+            }
+    }
+    return NULL;
+}
+
+std::vector<Disk::INode_t *> Disk::getFreeINodes(int32_t n, const INode_t *parentINode) {
+    std::vector<INode_t *> freeINodes;
+    int32_t group = getAllocationGroupOfNewINode(parentINode, false);
+
+    // the groups are locked in the same order by everyone
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (int32_t i = 0; i < allocationGroupCount; i++)
+        locks.emplace_back(allocationGroups[i].mtx);
+    for (int32_t i = 0; i < allocationGroupCount && (int32_t)freeINodes.size() < n; i++) {
+        AllocationGroup_t &allocationGroup = allocationGroups[(group + i) % allocationGroupCount];
+        for (int32_t j = allocationGroup.firstINode; j < allocationGroup.lastINode && (int32_t)freeINodes.size() < n; j++)
+            if (iNodes[j].isFree == true)
+                freeINodes.push_back(&iNodes[j]);
+    }
+    if ((int32_t)freeINodes.size() < n)
+        return std::vector<INode_t *>();
+    for (INode_t *iNode : freeINodes)
+        iNode->isFree = false;
+    return freeINodes;
+}
 
-        for (int32_t j = 0; j < numberOfEntriesInCluster; j++) {
-            directoryItems->items[index++] = buff[j];
-            if (index == directoryItems->count)
+int32_t Disk::allocatePackedSpace(int32_t size, int32_t *offset) {
+    LOG_INFO("Finding a free space within the shared clusters");
+    std::unique_lock<std::mutex> lock(allocatorMutex);
+    for (auto &cluster : packedClusters) {
+        // go through the gaps between the files stored in the cluster
+        int32_t start = 0;
+        for (auto &file : cluster.second) {
+            if (file.first - start >= size)
                 break;
+            start = file.first + file.second;
+        }
+        auto next = cluster.second.lower_bound(start);
+        int32_t end = next == cluster.second.end() ? superBlock->clusterSize : next->first;
+        if (end - start >= size) {
+            cluster.second[start] = size;
+            *offset = start;
+            return cluster.first;
         }
     }
-    delete[] buff;
-    return directoryItems;
+    LOG_INFO("Allocating a new shared cluster");
+    lock.unlock();
+    int32_t cluster = getFreeCluster();
+    if (cluster == NULL_POINTER) {
+        LOG_ERR("There's not enough free clusters in the file system");
+        return NULL_POINTER;
+    }
+    lock.lock();
+    packedClusters[cluster][0] = size;
+    lock.unlock();
+    *offset = 0;
+    saveBitmapOnDisk();
+    return cluster;
 }
 
-Disk::INode_t *Disk::getFreeINode() {
-    for (int i = 0; i < INODES_COUNT; i++)
-        if (iNodes[i].isFree == true)
-            return &iNodes[i];
-    return NULL;
+bool Disk::releasePackedSpace(int32_t cluster, int32_t offset) {
+    std::lock_guard<std::mutex> lock(allocatorMutex);
+    auto packedCluster = packedClusters.find(cluster);
+    if (packedCluster == packedClusters.end())
+        return false;
+    packedCluster->second.erase(offset);
+    if (packedCluster->second.empty() == false)
+        return false;
+    setClusterFree(cluster, true);
+    packedClusters.erase(packedCluster);
+    return true;
+}
+
+bool Disk::storePackedContent(INode_t *iNode, const char *data) {
+    int32_t offset;
+    int32_t cluster = allocatePackedSpace(iNode->size, &offset);
+    if (cluster == NULL_POINTER)
+        return false;
+    writeToDisk(data, sizeof(char), iNode->size, dataOffset(cluster) + offset);
+    iNode->direct[0] = cluster;
+    iNode->packOffset = offset;
+    return true;
+}
+
+std::string Disk::getPackedContent(INode_t *iNode) {
+    std::string content(iNode->size, '\0');
+    readFromDisk(&content[0], sizeof(char), iNode->size, dataOffset(iNode->direct[0]) + iNode->packOffset);
+    return content;
+}
+
+void Disk::loadPackedClusters() {
+    LOG_INFO("Building up the occupancy of the shared clusters");
+    packedClusters.clear();
+    for (int32_t i = 0; i < INODES_COUNT; i++)
+        if (iNodes[i].isFree == false && iNodes[i].packOffset != NULL_POINTER)
+            packedClusters[iNodes[i].direct[0]][iNodes[i].packOffset] = iNodes[i].size;
+}
+
+uint8_t Disk::getItemType(const INode_t *iNode) const {
+    if (iNode->isDirectory)
+        return ITEM_DIRECTORY;
+    if (iNode->isSymbolicLink)
+        return ITEM_SYMBOLIC_LINK;
+    return ITEM_FILE;
 }
 
 void Disk::incpyFile(INode_t *destinationINode, FILE *sourceFile, std::string fileName) {
     LOG_INFO("Copying the file into the file system");
     if (destinationINode == NULL) {
-        USER_ALERT("PATH NOT FOUND");
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
         return;
     }
-    if (destinationINode->isDirectory == false) {
-        USER_ALERT("CANNOT IN-COPY INTO A FILE");
-        return;
-    }
-    if (sourceFile == NULL) {
-        USER_ALERT("FILE NOT FOUND");
-        return;
+    SharedLock_t treeGuard(treeLock);
+    {
+        SharedLock_t iNodeGuard(iNodeLocks[destinationINode->nodeId]);
+        if (destinationINode->isDirectory == false) {
+            USER_ALERT(Logger::STATUS_CANNOT_INCOPY_INTO_FILE);
+            return;
+        }
+        if (sourceFile == NULL) {
+            USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
+            return;
+        }
+        if (existsInDirectory(destinationINode, fileName) == true) {
+            USER_ALERT(Logger::STATUS_EXISTS);
+            return;
+        }
     }
-    INode_t *fileINode = getFreeINode();
+    INode_t *fileINode = getFreeINode(destinationINode);
     if (fileINode == NULL) {
         LOG_ERR("all i-nodes are occupied");
         return;
     }
-    auto directoryItems = std::unique_ptr<DirectoryItems_t>(getDirectoryItemsFromINode(destinationINode));
-    if (directoryItems == NULL) {
-        LOG_ERR("Directory items is NULL");
-        return;
-    }
-    if (existsInDirectory(directoryItems.get(), fileName) == true) {
-        USER_ALERT("EXISTS");
-        return;
-    }
 
     LOG_INFO("Getting the size of the file");
     fseek(sourceFile, 0, SEEK_END);
     size_t fileSize = ftell(sourceFile);
     fseek(sourceFile, 0, SEEK_SET);
 
+    if (fileSize <= INLINE_DATA_LEN) {
+        // a tiny file is stored right in the i-node, so it
+        // takes up no cluster and the bitmap stays untouched
+        LOG_INFO("Storing the content of the file in the i-node");
+        if (fread(fileINode->inlineData, sizeof(char), fileSize, sourceFile) != fileSize) {
+            LOG_ERR("Reading the file failed");
+            removeINode(fileINode);
+            return;
+        }
+        fileINode->size = fileSize;
+        fileINode->isDirectory = false;
+        fileINode->isInline = true;
+        if (linkNewINode(destinationINode, fileINode, fileName) == false) {
+            removeINode(fileINode);
+            return;
+        }
+        USER_ALERT(Logger::STATUS_OK);
+        return;
+    }
+    if ((int32_t)fileSize < superBlock->clusterSize) {
+        // a small file shares a cluster with other small files
+        LOG_INFO("Storing the content of the file into a shared cluster");
+        auto buff = std::unique_ptr<char[]>(new char[fileSize]);
+        if (fread(buff.get(), sizeof(char), fileSize, sourceFile) != fileSize) {
+            LOG_ERR("Reading the file failed");
+            removeINode(fileINode);
+            return;
+        }
+        fileINode->size = fileSize;
+        fileINode->isDirectory = false;
+        if (storePackedContent(fileINode, buff.get()) == false || linkNewINode(destinationINode, fileINode, fileName) == false) {
+            removeINode(fileINode);
+            return;
+        }
+        USER_ALERT(Logger::STATUS_OK);
+        return;
+    }
     int32_t numberOfClustersNeeded = getNumberOfClustersNeeded(fileSize);
 
-    if (isThereAtLeastNFreeClusters(numberOfClustersNeeded) == false) {
+    LOG_INFO("Initialing free clusters for the file");
+    std::vector<int32_t> clusters = getFreeClusters(numberOfClustersNeeded, fileINode);
+    if ((int32_t)clusters.size() != numberOfClustersNeeded) {
         LOG_ERR("There's not enough free clusters in the file system");
+        removeINode(fileINode);
         return;
     }
 
-    LOG_INFO("Initialing free clusters for the file");
-    std::vector<int32_t> clusters;
-    for (int32_t i = 0; i < numberOfClustersNeeded; i++)
-        clusters.push_back(getFreeCluster());
-
-    auto buff = std::unique_ptr<char[]>(new char[superBlock->clusterSize + 1]);
-    int32_t remainingFileSize = fileSize;
-
     LOG_INFO("Starting reading the content of the file");
-    for (int32_t i = 0; i < numberOfClustersNeeded; i++) {
-        fseek(sourceFile, i * superBlock->clusterSize, SEEK_SET);
-        fread(buff.get(), sizeof(char), superBlock->clusterSize, sourceFile);
-
-        fseek(diskFile, dataOffset(clusters[i]), SEEK_SET);
-        if (remainingFileSize >= superBlock->clusterSize) {
-            buff[superBlock->clusterSize] = '\0';
-            fwrite(buff.get(), sizeof(char), superBlock->clusterSize, diskFile);
-        }
-        else {
-            buff[remainingFileSize] = '\0';
-            fwrite(buff.get(), sizeof(char), remainingFileSize, diskFile);
-        }
-        remainingFileSize -= superBlock->clusterSize;
+    if (importFileContent(sourceFile, fileSize, clusters) == false) {
+        LOG_ERR("Reading the file failed");
+        releaseClusters(clusters);
+        removeINode(fileINode);
+        return;
     }
-    fflush(diskFile);
 
+    // the clusters are attached before the file is added into the
+    // directory, so the file is never seen without its content
     fileINode->size = fileSize;
     fileINode->isDirectory = false;
-    fileINode->isFree = false;
-    addINodeToDirectory(directoryItems.get(), destinationINode, fileINode, fileName);
-
     if (attachClustersToINode(fileINode, clusters) == false) {
         LOG_ERR("Attaching clusters to the i-node failed");
+        releaseClusters(clusters);
+        removeINode(fileINode);
+        return;
+    }
+    if (linkNewINode(destinationINode, fileINode, fileName) == false) {
+        removeINode(fileINode);
         return;
     }
     LOG_INFO("Storing the changes on the disk");
     saveBitmapOnDisk();
     saveINodesOnDisk();
-    USER_ALERT("OK");
+    USER_ALERT(Logger::STATUS_OK);
 }
 
-bool Disk::attachClustersToINode(INode_t *iNode, std::vector<int32_t> clusters) {
-    LOG_INFO("Attaching clusters to the i-node");
-    int32_t index = 0;
-    int32_t numberOfPointersInCluster = superBlock->clusterSize / sizeof(int32_t);
-
-    LOG_INFO("Attaching the direct pointers");
-    for (; index < (int)clusters.size() && index < NUM_OF_DIRECT_POINTERS; index++)
-        iNode->direct[index] = clusters[index];
-
-    if (index < (int)clusters.size()) {
-        LOG_INFO("Attaching the the first indirect pointer");
-        if (isThereAtLeastNFreeClusters(1) == false) {
-            LOG_ERR("There's not enough free clusters in the file system");
-            return false;
-        }
-
-        int32_t count = 0;
-        int32_t *clustersBuff = new int32_t[numberOfPointersInCluster];
-        iNode->indirect[0] = getFreeCluster();
-
-        for (; count < (int)numberOfPointersInCluster && index < (int)clusters.size(); count++)
-            clustersBuff[count] = clusters[index++];
-
-        LOG_INFO("Storing the clusters of the first indirect pointers");
-        fseek(diskFile, dataOffset(iNode->indirect[0]), SEEK_SET);
-        fwrite(clustersBuff, sizeof(int32_t), count, diskFile);
-        fflush(diskFile);
-
-        delete[] clustersBuff;
-    }
-    if (index < (int)clusters.size()) {
-        LOG_INFO("Attaching the the second indirect pointer");
-
-        int32_t numberOfRemainingClusters = clusters.size() - index + 1;
-        int32_t numberOfMiddleClustersNeeded;
+bool Disk::importFileContent(FILE *sourceFile, size_t fileSize, const std::vector<int32_t> &clusters) {
+    size_t clustersPerBuffer = std::max(1, IMPORT_BUFFER_LEN / superBlock->clusterSize);
+    size_t bufferSize = clustersPerBuffer * superBlock->clusterSize;
+    size_t numberOfBuffers = (fileSize + bufferSize - 1) / bufferSize;
+    fseek(sourceFile, 0, SEEK_SET);
 
-        if (numberOfRemainingClusters < numberOfPointersInCluster)
-            numberOfMiddleClustersNeeded = 1;
-        else {
-            numberOfMiddleClustersNeeded = numberOfRemainingClusters / numberOfPointersInCluster;
-            if (numberOfRemainingClusters % numberOfPointersInCluster != 0)
-                numberOfMiddleClustersNeeded++;
-        }
-        if (isThereAtLeastNFreeClusters(numberOfMiddleClustersNeeded + 1) == false) {
-            LOG_ERR("There's not enough free clusters in the file system");
+    // there's nothing to overlap
+    if (numberOfBuffers <= 1) {
+        auto buff = std::unique_ptr<char[]>(new char[fileSize]);
+        if (fread(buff.get(), sizeof(char), fileSize, sourceFile) != fileSize)
             return false;
+        writeBuffer(buff.get(), fileSize, clusters, 0);
+        return true;
+    }
+
+    std::vector<std::unique_ptr<char[]>> buffers(std::min((size_t)IMPORT_BUFFER_COUNT, numberOfBuffers));
+    for (auto &buff : buffers)
+        buff.reset(new char[bufferSize]);
+    std::mutex mtx;
+    std::condition_variable cv;
+    size_t numberOfFilled = 0; // buffers read but not written yet
+    bool failed = false;       // set by the reader if the file cannot be read whole
+
+    std::thread reader([&]() {
+        for (size_t i = 0; i < numberOfBuffers; i++) {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [&]() { return numberOfFilled < buffers.size(); });
+            }
+            char *buff = buffers[i % buffers.size()].get();
+            size_t length = std::min(bufferSize, fileSize - i * bufferSize);
+            bool read = fread(buff, sizeof(char), length, sourceFile) == length;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (read)
+                    numberOfFilled++;
+                else failed = true;
+            }
+            cv.notify_all();
+            if (read == false)
+                return;
         }
-        if (numberOfMiddleClustersNeeded > numberOfPointersInCluster) {
-            LOG_ERR("The file is too big for this file system");
-            return false;
+    });
+    for (size_t i = 0; i < numberOfBuffers; i++) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [&]() { return numberOfFilled > 0 || failed; });
+            if (failed)
+                break;
         }
-        LOG_INFO("Getting remaining free clusters");
-        int32_t *middleClusters = new int32_t[numberOfMiddleClustersNeeded];
-        for (int i = 0; i < numberOfMiddleClustersNeeded; i++)
-            middleClusters[i] = getFreeCluster();
-
-        LOG_INFO("Storing the middle clusters");
-        iNode->indirect[1] = getFreeCluster();
-        fseek(diskFile, dataOffset(iNode->indirect[1]), SEEK_SET);
-        fwrite(middleClusters, sizeof(int32_t), numberOfMiddleClustersNeeded, diskFile);
-        fflush(diskFile);
-
-        int32_t count = 0;
-        int32_t *clustersBuff = new int32_t[numberOfPointersInCluster];
-
-        LOG_INFO("Started storing remaining clusters");
-        for (int i = 0; i < numberOfMiddleClustersNeeded; i++) {
-            for (int j = 0; j < numberOfPointersInCluster; j++) {
-                if (index == (int)clusters.size())
-                    break;
-                clustersBuff[j] = clusters[index++];
-                count++;
-            }
-            fseek(diskFile, dataOffset(middleClusters[i]), SEEK_SET);
-            fwrite(clustersBuff, sizeof(int32_t), count, diskFile);
-            count = 0;
+        size_t length = std::min(bufferSize, fileSize - i * bufferSize);
+        writeBuffer(buffers[i % buffers.size()].get(), length, clusters, i * clustersPerBuffer);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            numberOfFilled--;
         }
-        fflush(diskFile);
+        cv.notify_all();
+    }
+    reader.join();
+    return failed == false;
+}
 
-        delete[] clustersBuff;
-        delete[] middleClusters;
+void Disk::writeBuffer(const char *buff, size_t length, const std::vector<int32_t> &clusters, size_t first) {
+    size_t clusterSize = superBlock->clusterSize;
+    size_t count = (length + clusterSize - 1) / clusterSize;
+    for (size_t i = 0; i < count;) {
+        size_t last = i + 1;
+        while (last < count && clusters[first + last] == clusters[first + last - 1] + 1)
+            last++;
+        size_t runLength = std::min((last - i) * clusterSize, length - i * clusterSize);
+        writeToDisk(buff + i * clusterSize, sizeof(char), runLength, dataOffset(clusters[first + i]));
+        i = last;
     }
-    return true;
 }
 
-void Disk::addINodeToDirectory(DirectoryItems_t *directoryItems, INode_t *directoryINode, INode_t *newINode, std::string name) {
-    LOG_INFO("Adding i-node into the directory");
-    if (directoryItems == NULL) {
-        LOG_ERR("Directory is NULL");
+void Disk::incpyDirectory(INode_t *destinationINode, std::string sourcePath, std::string directoryName) {
+    LOG_INFO("Importing the directory into the file system");
+    if (destinationINode == NULL) {
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
         return;
     }
-    if (directoryINode == NULL) {
-        LOG_ERR("Directory i-node is NULL");
+    struct stat sourceStat;
+    if (stat(sourcePath.c_str(), &sourceStat) != 0) {
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
         return;
     }
-    if (newINode == NULL) {
-        LOG_ERR("new i-node is NULL");
+    if (S_ISDIR(sourceStat.st_mode) == false) {
+        FILE *sourceFile = fopen(sourcePath.c_str(), "rb");
+        incpyFile(destinationINode, sourceFile, directoryName);
+        if (sourceFile != NULL)
+            fclose(sourceFile);
         return;
     }
-    newINode->parentId = directoryINode->nodeId;
-    directoryItems->count++;
-    DirectoryItem_t *newEntries = new DirectoryItem_t[directoryItems->count];
+    if (directoryName == "") {
+        LOG_ERR("The Name of the directory is NULL");
+        return;
+    }
+    std::vector<ImportedItem_t> items;
+    if (readHostDirectoryTree(sourcePath, directoryName, items) == false) {
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
+        return;
+    }
+    SharedLock_t treeGuard(treeLock);
+    {
+        SharedLock_t iNodeGuard(iNodeLocks[destinationINode->nodeId]);
+        if (destinationINode->isFree) {
+            USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
+            return;
+        }
+        if (destinationINode->isDirectory == false) {
+            USER_ALERT(Logger::STATUS_NOT_A_DIRECTORY);
+            return;
+        }
+        if (existsInDirectory(destinationINode, items[0].name)) {
+            USER_ALERT(Logger::STATUS_EXISTS);
+            return;
+        }
+    }
+    LOG_INFO("Claiming the i-nodes of all the imported items");
+    std::vector<INode_t *> newINodes = getFreeINodes(items.size(), destinationINode);
+    if (newINodes.size() != items.size()) {
+        LOG_ERR("All i-nodes are occupied");
+        return;
+    }
+    bool imported = true;
+
+    // the tree is built aside and added into the destination directory only
+    // once it's complete, so no one else can get to it in the meantime
+    LOG_INFO("Creating the directories");
+    for (size_t i = 0; i < items.size(); i++) {
+        ImportedItem_t &item = items[i];
+        INode_t *parentINode = item.parent == NULL_POINTER ? destinationINode : items[item.parent].iNode;
+        item.iNode = newINodes[i];
+        if (parentINode != NULL && item.isDirectory == false)
+            item.iNode->parentId = parentINode->nodeId; // see #getFreeINode
+        if (parentINode == NULL) {
+            // the parent directory has not been imported
+            removeINode(item.iNode);
+            item.iNode = NULL;
+        }
+        else if (item.parent == NULL_POINTER) {
+            auto newDir = std::unique_ptr<DirectoryItems_t>(new DirectoryItems_t(item.iNode->nodeId, destinationINode->nodeId));
+            item.iNode->isDirectory = true;
+            if (resizeDirectory(item.iNode, newDir->count) == false) {
+                LOG_ERR("There's not enough free clusters in the file system");
+                removeINode(item.iNode);
+                item.iNode = NULL;
+            }
+            else saveDirectoryItemsOnDisk(item.iNode, newDir.get());
+        }
+        else if (item.isDirectory && existsInDirectory(parentINode, item.name)) {
+            LOG_ERR("There already is an item named " + item.name);
+            removeINode(item.iNode);
+            item.iNode = NULL;
+        }
+        else if (item.isDirectory && initFolder(item.iNode, parentINode, item.name) == false)
+            item.iNode = NULL;
+        if (item.iNode == NULL)
+            imported = false;
+    }
+
+    LOG_INFO("Importing the content of the files");
+    auto importedFiles = std::unique_ptr<bool[]>(new bool[items.size()]());
+    auto failedFiles = std::unique_ptr<std::atomic<bool>[]>(new std::atomic<bool>[items.size()]());
+    {
+        ThreadPool::Batch tasks;
+        for (size_t i = 0; i < items.size(); i++) {
+            if (items[i].isDirectory || items[i].iNode == NULL)
+                continue;
+            threadPool.addTask([this, &items, &importedFiles, &failedFiles, &tasks, i]() {
+                importedFiles[i] = importHostFile(items[i], tasks, failedFiles[i]);
+            }, tasks);
+        }
+        threadPool.wait(tasks);
+    }
+
+    LOG_INFO("Adding the files into their directories");
+    for (size_t i = 0; i < items.size(); i++) {
+        ImportedItem_t &item = items[i];
+        if (item.isDirectory || item.iNode == NULL)
+            continue;
+        INode_t *parentINode = items[item.parent].iNode;
+        if (importedFiles[i] == false || failedFiles[i] || existsInDirectory(parentINode, item.name) ||
+            addINodeToDirectory(parentINode, item.iNode, item.name) == false) {
+            LOG_ERR("The file " + item.path + " has not been imported");
+            removeINode(item.iNode);
+            imported = false;
+        }
+    }
+
+    LOG_INFO("Adding the imported directory into the destination directory");
+    if (items[0].iNode != NULL && linkNewINode(destinationINode, items[0].iNode, items[0].name) == false) {
+        // the whole tree is released, the items are removed after their directories
+        for (auto it = items.rbegin(); it != items.rend(); it++)
+            if (it->iNode != NULL)
+                removeINode(it->iNode);
+        saveBitmapOnDisk();
+        saveINodesOnDisk();
+        return;
+    }
+    LOG_INFO("Storing the changes on the disk");
+    saveBitmapOnDisk();
+    saveINodesOnDisk();
+    if (imported == false) {
+        LOG_ERR("The directory has not been imported completely");
+        return;
+    }
+    USER_ALERT(Logger::STATUS_OK);
+}
+
+bool Disk::readHostDirectoryTree(std::string path, std::string name, std::vector<ImportedItem_t> &items) {
+    LOG_INFO("Walking through the directory tree on the HDD");
+    items.push_back({path, normalizeName(name), NULL_POINTER, true, 0, NULL});
+    for (size_t i = 0; i < items.size(); i++) {
+        if (items[i].isDirectory == false)
+            continue;
+        DIR *directory = opendir(items[i].path.c_str());
+        if (directory == NULL) {
+            LOG_ERR("Reading the directory " + items[i].path + " failed");
+            if (i == 0)
+                return false;
+            continue;
+        }
+        std::vector<std::string> names;
+        struct dirent *entry;
+        while ((entry = readdir(directory)) != NULL)
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+                names.push_back(entry->d_name);
+        closedir(directory);
+        std::sort(names.begin(), names.end());
+
+        for (auto &entryName : names) {
+            std::string entryPath = items[i].path + "/" + entryName;
+            struct stat entryStat;
+            if (lstat(entryPath.c_str(), &entryStat) != 0 || (S_ISDIR(entryStat.st_mode) == false && S_ISREG(entryStat.st_mode) == false)) {
+                LOG_INFO("Skipping " + entryPath);
+                continue;
+            }
+            bool isDirectory = S_ISDIR(entryStat.st_mode);
+            items.push_back({entryPath, normalizeName(entryName), (int32_t)i, isDirectory, isDirectory ? 0 : (int64_t)entryStat.st_size, NULL});
+        }
+    }
+    return true;
+}
+
+bool Disk::importHostFile(const ImportedItem_t &item, ThreadPool::Batch &tasks, std::atomic<bool> &failed) {
+    INode_t *fileINode = item.iNode;
+    fileINode->size = item.size;
+    fileINode->isDirectory = false;
+
+    if (item.size < superBlock->clusterSize) {
+        // a tiny file goes into the i-node and a small one into a shared cluster
+        FILE *sourceFile = fopen(item.path.c_str(), "rb");
+        if (sourceFile == NULL) {
+            LOG_ERR("Reading the file " + item.path + " failed");
+            return false;
+        }
+        auto buff = std::unique_ptr<char[]>(new char[item.size + 1]);
+        size_t count = fread(buff.get(), sizeof(char), item.size, sourceFile);
+        fclose(sourceFile);
+        if ((int64_t)count != item.size) {
+            LOG_ERR("Reading the file " + item.path + " failed");
+            return false;
+        }
+        if (item.size <= INLINE_DATA_LEN) {
+            memcpy(fileINode->inlineData, buff.get(), item.size);
+            fileINode->isInline = true;
+            return true;
+        }
+        return storePackedContent(fileINode, buff.get());
+    }
+    int32_t numberOfClustersNeeded = getNumberOfClustersNeeded(item.size);
+    std::vector<int32_t> clusters = getFreeClusters(numberOfClustersNeeded, fileINode);
+    if ((int32_t)clusters.size() != numberOfClustersNeeded) {
+        LOG_ERR("There's not enough free clusters in the file system");
+        return false;
+    }
+    if (attachClustersToINode(fileINode, clusters) == false) {
+        LOG_ERR("Attaching clusters to the i-node failed");
+        releaseClusters(clusters);
+        return false;
+    }
+    auto importRun = [this, &failed](std::string path, off_t offset, int64_t length, std::vector<int32_t> run) {
+        auto buff = std::unique_ptr<char[]>(new char[length]());
+        int sourceFile = open(path.c_str(), O_RDONLY);
+        int64_t done = 0;
+        while (sourceFile >= 0 && done < length) {
+            ssize_t n = pread(sourceFile, buff.get() + done, length - done, offset + done);
+            if (n <= 0)
+                break;
+            done += n;
+        }
+        if (sourceFile >= 0)
+            close(sourceFile);
+        if (done < length) {
+            // the file is not added into its directory
+            LOG_ERR("Reading the file " + path + " failed");
+            failed = true;
+            return;
+        }
+
+        // consecutive clusters are written at once
+        for (size_t first = 0; first < run.size();) {
+            size_t last = first + 1;
+            while (last < run.size() && run[last] == run[last - 1] + 1)
+                last++;
+            int64_t start = (int64_t)first * superBlock->clusterSize;
+            int64_t count = std::min<int64_t>(length - start, (int64_t)(last - first) * superBlock->clusterSize);
+            writeToDisk(buff.get() + start, sizeof(char), count, dataOffset(run[first]));
+            first = last;
+        }
+    };
+    for (int32_t first = 0; first < numberOfClustersNeeded; first += COPY_RUN_LEN) {
+        int32_t last = std::min(first + COPY_RUN_LEN, numberOfClustersNeeded);
+        off_t offset = (off_t)first * superBlock->clusterSize;
+        int64_t length = std::min<int64_t>(item.size - offset, (int64_t)(last - first) * superBlock->clusterSize);
+        threadPool.addTask(std::bind(importRun, item.path, offset, length, std::vector<int32_t>(clusters.begin() + first, clusters.begin() + last)), tasks);
+    }
+    return true;
+}
+
+bool Disk::attachClustersToINode(INode_t *iNode, std::vector<int32_t> clusters) {
+    LOG_INFO("Attaching clusters to the i-node");
+    int32_t index = 0;
+    int32_t numberOfPointersInCluster = superBlock->clusterSize / sizeof(int32_t);
+    int32_t numberOfRemainingClusters = (int32_t)clusters.size() - NUM_OF_DIRECT_POINTERS - numberOfPointersInCluster;
+    int32_t numberOfMiddleClustersNeeded = 0;
+    if (numberOfRemainingClusters > 0)
+        numberOfMiddleClustersNeeded = (numberOfRemainingClusters + numberOfPointersInCluster - 1) / numberOfPointersInCluster;
+    if (numberOfMiddleClustersNeeded > numberOfPointersInCluster) {
+        LOG_ERR("The file is too big for this file system");
+        return false;
+    }
+
+    LOG_INFO("Allocating the indirect clusters");
+    // the first indirect cluster, the second indirect cluster and the middle clusters
+    // are allocated all at once, so the i-node is left untouched if there are not enough of them
+    int32_t numberOfIndirectClustersNeeded = (int32_t)clusters.size() > NUM_OF_DIRECT_POINTERS ? 1 : 0;
+    if (numberOfMiddleClustersNeeded > 0)
+        numberOfIndirectClustersNeeded += 1 + numberOfMiddleClustersNeeded;
+    std::vector<int32_t> indirectClusters = getFreeClusters(numberOfIndirectClustersNeeded, iNode);
+    if ((int32_t)indirectClusters.size() != numberOfIndirectClustersNeeded) {
+        LOG_ERR("There's not enough free clusters in the file system");
+        return false;
+    }
+
+    LOG_INFO("Attaching the direct pointers");
+    for (; index < (int)clusters.size() && index < NUM_OF_DIRECT_POINTERS; index++)
+        iNode->direct[index] = clusters[index];
+
+    if (index < (int)clusters.size()) {
+        LOG_INFO("Attaching the the first indirect pointer");
+        int32_t count = std::min(numberOfPointersInCluster, (int32_t)clusters.size() - index);
+        iNode->indirect[0] = indirectClusters[0];
 
-    LOG_INFO("Adding a new item into the directory");
-    newEntries[directoryItems->count - 1].iNode = newINode->nodeId;
-    strcpy(newEntries[directoryItems->count - 1].itemName, name.c_str());
+        LOG_INFO("Storing the clusters of the first indirect pointers");
+        writeToDisk(&clusters[index], sizeof(int32_t), count, dataOffset(iNode->indirect[0]));
+        index += count;
+    }
+    if (index < (int)clusters.size()) {
+        LOG_INFO("Attaching the the second indirect pointer");
+        const int32_t *middleClusters = &indirectClusters[2];
 
-    LOG_INFO("Copying the rest of the items of the directory");
-    for (size_t i = 0; i < directoryItems->count - 1; i++)
-        newEntries[i] = directoryItems->items[i];
+        LOG_INFO("Storing the middle clusters");
+        iNode->indirect[1] = indirectClusters[1];
+        writeToDisk(middleClusters, sizeof(int32_t), numberOfMiddleClustersNeeded, dataOffset(iNode->indirect[1]));
 
-    LOG_INFO("Attaching the new items to the directory");
-    DirectoryItem_t *tmp = directoryItems->items;
-    directoryItems->items = newEntries;
-    delete[] tmp;
+        LOG_INFO("Started storing remaining clusters");
+        for (int i = 0; i < numberOfMiddleClustersNeeded; i++) {
+            int32_t count = std::min(numberOfPointersInCluster, (int32_t)clusters.size() - index);
+            writeToDisk(&clusters[index], sizeof(int32_t), count, dataOffset(middleClusters[i]));
+            index += count;
+        }
+    }
+    return true;
+}
 
-    directoryINode->size = sizeof(size_t) + directoryItems->count * sizeof(DirectoryItem_t);
-    saveDirectoryItemsOnDisk(directoryINode, directoryItems);
+bool Disk::addINodeToDirectory(INode_t *directoryINode, INode_t *newINode, std::string name) {
+    LOG_INFO("Adding i-node into the directory");
+    if (directoryINode == NULL) {
+        LOG_ERR("Directory i-node is NULL");
+        return false;
+    }
+    if (newINode == NULL) {
+        LOG_ERR("new i-node is NULL");
+        return false;
+    }
+    int32_t position = (directoryINode->size - sizeof(size_t)) / sizeof(DirectoryItem_t);
+    int32_t numberOfClusters = getNumberOfClustersOfINode(directoryINode);
+    if (resizeDirectory(directoryINode, position + 1) == false) {
+        LOG_ERR("There's not enough free clusters to store the directory");
+        return false;
+    }
+    newINode->parentId = directoryINode->nodeId;
+    updateSubtreeUsage(directoryINode, newINode, true);
+
+    LOG_INFO("Appending the new item at the end of the directory");
+    DirectoryItem_t item = {};
+    item.iNode = newINode->nodeId;
+    item.type = getItemType(newINode);
+    strcpy(item.itemName, name.c_str());
+    saveDirectoryItemOnDisk(directoryINode, position, &item);
+    saveNumberOfDirectoryItemsOnDisk(directoryINode);
+
+    addToDirectoryIndex(directoryINode, name.c_str(), position);
+    cacheDentry(directoryINode->nodeId, name, newINode->nodeId);
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        iNodeNames[newINode->nodeId] = std::string(item.itemName, strnlen(item.itemName, FILE_NAME_LEN));
+    }
     saveINodesOnDisk();
+    if (numberOfClusters != getNumberOfClustersOfINode(directoryINode))
+        saveBitmapOnDisk();
+    return true;
+}
+
+bool Disk::linkNewINode(INode_t *directoryINode, INode_t *newINode, std::string name) {
+    ExclusiveLock_t iNodeGuard(iNodeLocks[directoryINode->nodeId]);
+    if (directoryINode->isDirectory == false) {
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
+        return false;
+    }
+    if (existsInDirectory(directoryINode, name)) {
+        USER_ALERT(Logger::STATUS_EXISTS);
+        return false;
+    }
+    return addINodeToDirectory(directoryINode, newINode, name);
+}
+
+void Disk::saveDirectoryItemOnDisk(INode_t *directoryINode, int32_t position, const DirectoryItem_t *item) {
+    writeToDisk(item, sizeof(DirectoryItem_t), 1, getDirectoryItemOffset(directoryINode, position));
+}
+
+void Disk::saveNumberOfDirectoryItemsOnDisk(INode_t *directoryINode) {
+    size_t count = (directoryINode->size - sizeof(size_t)) / sizeof(DirectoryItem_t);
+    writeToDisk(&count, sizeof(size_t), 1, dataOffset(directoryINode->direct[0]));
 }
 
-bool Disk::existsInDirectory(DirectoryItems_t *directoryItems, std::string name) {
+bool Disk::existsInDirectory(INode_t *directoryINode, std::string name) {
     LOG_INFO("Checking whether or not there's an item in the directory named " + name);
-    if (directoryItems == NULL) {
+    if (directoryINode == NULL) {
         LOG_ERR("Directory is NULL");
         return false;
     }
-    for (size_t i = 0; i < directoryItems->count; i++)
-        if (std::string(directoryItems->items[i].itemName) == name)
-            return true;
-    return false;
+    return lookupInDirectory(directoryINode, name) != NULL_POINTER;
 }
 
 std::vector<std::int32_t> Disk::getAllClustersOfINode(INode_t *iNode) {
@@ -660,7 +1626,7 @@ std::vector<std::int32_t> Disk::getAllClustersOfINode(INode_t *iNode) {
         else return clusters;
     }
 
-    int32_t numberOfClustersNeeded = getNumberOfClustersNeeded(iNode->size) - NUM_OF_DIRECT_POINTERS;
+    int32_t numberOfClustersNeeded = getNumberOfClustersOfINode(iNode) - NUM_OF_DIRECT_POINTERS;
     int32_t numberOfPointersInCluster = superBlock->clusterSize / sizeof(int32_t);
 
     if (numberOfClustersNeeded <= 0)
@@ -670,8 +1636,7 @@ std::vector<std::int32_t> Disk::getAllClustersOfINode(INode_t *iNode) {
     int32_t *firstIndirectClusters = new int32_t[count];
 
     LOG_INFO("Getting first indirect clusters");
-    fseek(diskFile, dataOffset(iNode->indirect[0]), SEEK_SET);
-    fread(firstIndirectClusters, sizeof(int32_t), count, diskFile);
+    readFromDisk(firstIndirectClusters, sizeof(int32_t), count, dataOffset(iNode->indirect[0]));
 
     for (int i = 0; i < count; i++)
         clusters.push_back(firstIndirectClusters[i]);
@@ -695,13 +1660,11 @@ std::vector<std::int32_t> Disk::getAllClustersOfINode(INode_t *iNode) {
     int32_t *middleClusters = new int32_t[numberOfMiddleClusters];
     int32_t *clustersBuff = new int32_t[numberOfPointersInCluster];
 
-    fseek(diskFile, dataOffset(iNode->indirect[1]), SEEK_SET);
-    fread(middleClusters, sizeof(int32_t), numberOfMiddleClusters, diskFile);
+    readFromDisk(middleClusters, sizeof(int32_t), numberOfMiddleClusters, dataOffset(iNode->indirect[1]));
 
     for (int i = 0; i < numberOfMiddleClusters; i++) {
         count = std::min(numberOfClustersNeeded, numberOfPointersInCluster);
-        fseek(diskFile, dataOffset(middleClusters[i]), SEEK_SET);
-        fread(clustersBuff, sizeof(int32_t), count, diskFile);
+        readFromDisk(clustersBuff, sizeof(int32_t), count, dataOffset(middleClusters[i]));
         for (int j = 0; j < count; j++)
             clusters.push_back(clustersBuff[j]);
         numberOfClustersNeeded -= count;
@@ -715,39 +1678,196 @@ std::vector<std::int32_t> Disk::getAllClustersOfINode(INode_t *iNode) {
 void Disk::outcpyFile(INode_t *sourceINode, FILE *destinationFile) {
     LOG_INFO("Out copying the file from the file system");
     if (sourceINode == NULL) {
-        USER_ALERT("FILE NOT FOUND");
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
         return;
     }
     if (destinationFile == NULL) {
-        USER_ALERT("PATH NOT FOUND");
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
+        return;
+    }
+    SharedLock_t treeGuard(treeLock);
+    SharedLock_t iNodeGuard(iNodeLocks[sourceINode->nodeId]);
+    if (sourceINode->isFree) {
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
         return;
     }
     if (sourceINode->isSymbolicLink) {
+        // the locks are released before the path is followed
         std::string path = getPathFromSLink(sourceINode);
+        iNodeGuard.unlock();
+        treeGuard.unlock();
         INode_t *iNode = getINodeFromPath(path);
         outcpyFile(iNode, destinationFile);
     }
+    else if (sourceINode->isInline) {
+        LOG_INFO("Writing out the content stored in the i-node");
+        fwrite(sourceINode->inlineData, sizeof(char), sourceINode->size, destinationFile);
+        fflush(destinationFile);
+        USER_ALERT(Logger::STATUS_OK);
+    }
+    else if (sourceINode->packOffset != NULL_POINTER) {
+        LOG_INFO("Writing out the content stored in a shared cluster");
+        std::string content = getPackedContent(sourceINode);
+        fwrite(content.data(), sizeof(char), content.length(), destinationFile);
+        fflush(destinationFile);
+        USER_ALERT(Logger::STATUS_OK);
+    }
     else {
-        char *buff = new char[superBlock->clusterSize];
-        std::vector<int32_t> clusters = getAllClustersOfINode(sourceINode);
-        int32_t remainingFileSize = sourceINode->size;
-
-        for (int i = 0; i < (int) clusters.size(); i++) {
-            fseek(diskFile, dataOffset(clusters[i]), SEEK_SET);
-            fseek(destinationFile, i * superBlock->clusterSize, SEEK_SET);
-
-            if (remainingFileSize >= superBlock->clusterSize) {
-                fread(buff, sizeof(char), superBlock->clusterSize, diskFile);
-                fwrite(buff, sizeof(char), superBlock->clusterSize, destinationFile);
-            } else {
-                fread(buff, sizeof(char), remainingFileSize, diskFile);
-                fwrite(buff, sizeof(char), remainingFileSize, destinationFile);
+        FileReader reader(this, sourceINode);
+        std::string data;
+        while (reader.next(data))
+            fwrite(data.data(), sizeof(char), data.length(), destinationFile);
+        fflush(destinationFile);
+        USER_ALERT(Logger::STATUS_OK);
+    }
+}
+
+void Disk::outcpyDirectory(INode_t *directoryINode, std::string destinationPath) {
+    LOG_INFO("Exporting the directory from the file system");
+    if (directoryINode == NULL) {
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
+        return;
+    }
+    if (directoryINode->isDirectory == false) {
+        FILE *destinationFile = fopen(destinationPath.c_str(), "wb");
+        outcpyFile(directoryINode, destinationFile);
+        if (destinationFile != NULL)
+            fclose(destinationFile);
+        return;
+    }
+    SharedLock_t treeGuard(treeLock);
+    if (directoryINode->isFree) {
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
+        return;
+    }
+    if (mkdir(destinationPath.c_str(), 0755) != 0 && errno != EEXIST) {
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
+        return;
+    }
+    std::unordered_map<int32_t, std::vector<DirectoryItem_t>> tree = readDirectoryTree(directoryINode);
+    std::atomic<bool> exported{true};
+
+    LOG_INFO("Creating the directories on the HDD");
+    std::vector<ExportedFile_t> files;
+    std::queue<std::pair<int32_t, std::string>> directories;
+    directories.push({directoryINode->nodeId, destinationPath});
+    while (directories.empty() == false) {
+        auto directory = directories.front();
+        directories.pop();
+        for (auto &item : tree[directory.first]) {
+            std::string path = directory.second + "/" + std::string(item.itemName, strnlen(item.itemName, FILE_NAME_LEN));
+            if (iNodes[item.iNode].isDirectory == false) {
+                files.push_back({item.iNode, directory.first, path});
+                continue;
+            }
+            if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+                LOG_ERR("Creating the directory " + path + " failed");
+                exported = false;
+                continue;
             }
-            remainingFileSize -= superBlock->clusterSize;
+            directories.push({item.iNode, path});
         }
-        fflush(destinationFile);
-        delete[] buff;
-        USER_ALERT("OK");
+    }
+
+    LOG_INFO("Writing the files onto the HDD");
+    std::mutex mtx;
+    std::condition_variable fileWritten;
+    int32_t filesReadAhead = 0;
+    {
+        ThreadPool::Batch tasks;
+        for (auto &file : files) {
+            INode_t *iNode = &iNodes[file.iNodeId];
+            std::vector<int32_t> clusters;
+            {
+                SharedLock_t iNodeGuard(iNodeLocks[file.iNodeId]);
+                if (iNode->isFree || iNode->parentId != file.parentId) {
+                    LOG_ERR("The file " + file.path + " has been removed");
+                    exported = false;
+                    continue;
+                }
+                if (iNode->isSymbolicLink) {
+                    if (symlink(getPathFromSLink(iNode).c_str(), file.path.c_str()) != 0 && errno != EEXIST) {
+                        LOG_ERR("Creating the symbolic link " + file.path + " failed");
+                        exported = false;
+                    }
+                    continue;
+                }
+                // the cluster list is read ahead of the writers, so the content
+                // of the clusters is being prefetched while the previous files are written
+                if (iNode->isInline == false && iNode->packOffset == NULL_POINTER) {
+                    clusters = getAllClustersOfINode(iNode);
+                    prefetchClusters(clusters);
+                }
+            }
+            std::unique_lock<std::mutex> lock(mtx);
+            fileWritten.wait(lock, [&filesReadAhead]() {
+                return filesReadAhead < EXPORT_READ_AHEAD;
+            });
+            filesReadAhead++;
+            lock.unlock();
+
+            std::string path = file.path;
+            threadPool.addTask([this, iNode, clusters, path, &exported, &mtx, &fileWritten, &filesReadAhead]() {
+                if (exportFile(iNode, clusters, path) == false) {
+                    LOG_ERR("Writing the file " + path + " failed");
+                    exported = false;
+                }
+                std::lock_guard<std::mutex> lock(mtx);
+                filesReadAhead--;
+                fileWritten.notify_one();
+            }, tasks);
+        }
+        threadPool.wait(tasks);
+    }
+    if (exported == false) {
+        LOG_ERR("The directory has not been exported completely");
+        return;
+    }
+    USER_ALERT(Logger::STATUS_OK);
+}
+
+bool Disk::exportFile(INode_t *iNode, const std::vector<int32_t> &clusters, std::string path) {
+    SharedLock_t iNodeGuard(iNodeLocks[iNode->nodeId]);
+    if (iNode->isFree)
+        return false;
+    FILE *destinationFile = fopen(path.c_str(), "wb");
+    if (destinationFile == NULL)
+        return false;
+
+    if (iNode->isInline)
+        fwrite(iNode->inlineData, sizeof(char), iNode->size, destinationFile);
+    else if (iNode->packOffset != NULL_POINTER) {
+        std::string content = getPackedContent(iNode);
+        fwrite(content.data(), sizeof(char), content.length(), destinationFile);
+    }
+    else {
+        auto buff = std::unique_ptr<char[]>(new char[COPY_RUN_LEN * superBlock->clusterSize]);
+        int64_t remainingFileSize = iNode->size;
+
+        // consecutive clusters are read at once
+        for (size_t first = 0; first < clusters.size() && remainingFileSize > 0;) {
+            size_t last = first + 1;
+            while (last < clusters.size() && last - first < COPY_RUN_LEN && clusters[last] == clusters[last - 1] + 1)
+                last++;
+            int64_t length = std::min<int64_t>(remainingFileSize, (int64_t)(last - first) * superBlock->clusterSize);
+            readFromDisk(buff.get(), sizeof(char), length, dataOffset(clusters[first]));
+            fwrite(buff.get(), sizeof(char), length, destinationFile);
+            remainingFileSize -= length;
+            first = last;
+        }
+    }
+    bool written = ferror(destinationFile) == 0;
+    fclose(destinationFile);
+    return written;
+}
+
+void Disk::prefetchClusters(const std::vector<int32_t> &clusters) {
+    for (size_t first = 0; first < clusters.size();) {
+        size_t last = first + 1;
+        while (last < clusters.size() && clusters[last] == clusters[last - 1] + 1)
+            last++;
+        posix_fadvise(fileno(diskFile), dataOffset(clusters[first]), (last - first) * superBlock->clusterSize, POSIX_FADV_WILLNEED);
+        first = last;
     }
 }
 
@@ -765,59 +1885,61 @@ std::string Disk::getPathFromSLink(INode_t *iNode) {
         LOG_ERR("The i-node is not a symbolic link");
         return "";
     }
-    std::vector<int32_t> clusters = getAllClustersOfINode(iNode);
-    char *buff = new char[superBlock->clusterSize + 1];
-    int32_t remainingFileSize = iNode->size;
-    std::stringstream ss;
-
-    LOG_INFO("Starting printing out the content of the file");
-    for (int32_t cluster : clusters) {
-        fseek(diskFile, dataOffset(cluster), SEEK_SET);
-        fread(buff, sizeof(char), superBlock->clusterSize, diskFile);
-
-        if (remainingFileSize >= superBlock->clusterSize)
-            buff[superBlock->clusterSize] = '\0';
-        else buff[remainingFileSize] = '\0';
-        remainingFileSize -= superBlock->clusterSize;
-        ss << std::string(buff);
-    }
-    delete buff;
-    return ss.str();
+    if (iNode->isInline)
+        return std::string(iNode->inlineData, iNode->size);
+    if (iNode->packOffset != NULL_POINTER)
+        return getPackedContent(iNode);
+    FileReader reader(this, iNode);
+    std::string path;
+    std::string data;
+    while (reader.next(data))
+        path += data;
+    return path;
 }
 
-void Disk::printFileContent(INode_t *iNode, bool includeSlinks) {
+void Disk::printFileContent(INode_t *iNode, bool includeSlinks, std::ostream &stream) {
     LOG_INFO("Printing out the content of the file");
     if (iNode == NULL) {
-        USER_ALERT("FILE NOT FOUND");
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
+        return;
+    }
+    SharedLock_t treeGuard(treeLock);
+    SharedLock_t iNodeGuard(iNodeLocks[iNode->nodeId]);
+    if (iNode->isFree) {
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
         return;
     }
     if (iNode->isDirectory == true) {
-        USER_ALERT("CANNOT PRINT OUT DIRECTORY");
+        USER_ALERT(Logger::STATUS_CANNOT_PRINT_DIRECTORY);
         return;
     }
     if (includeSlinks && iNode->isSymbolicLink) {
+        // the locks are released before the path is followed
         std::string path = getPathFromSLink(iNode);
+        iNodeGuard.unlock();
+        treeGuard.unlock();
         INode_t *fileINode = getINodeFromPath(path);
-        printFileContent(fileINode, true);
+        printFileContent(fileINode, true, stream);
+        return;
+    }
+    if (iNode->isInline) {
+        LOG_INFO("Printing out the content stored in the i-node");
+        stream.write(iNode->inlineData, iNode->size);
+    }
+    else if (iNode->packOffset != NULL_POINTER) {
+        LOG_INFO("Printing out the content stored in a shared cluster");
+        stream << getPackedContent(iNode);
     }
     else {
-        std::vector<std::int32_t> clusters = getAllClustersOfINode(iNode);
-        char *buff = new char[superBlock->clusterSize + 1];
-        int32_t remainingFileSize = iNode->size;
+        FileReader reader(this, iNode);
+        std::string data;
 
         LOG_INFO("Starting printing out the content of the file");
-        for (int32_t cluster : clusters) {
-            fseek(diskFile, dataOffset(cluster), SEEK_SET);
-            fread(buff, sizeof(char), superBlock->clusterSize, diskFile);
-
-            if (remainingFileSize >= superBlock->clusterSize)
-                buff[superBlock->clusterSize] = '\0';
-            else buff[remainingFileSize] = '\0';
-            remainingFileSize -= superBlock->clusterSize;
-            std::cout << buff;
-        }
-        delete buff;
+        while (reader.next(data))
+            stream.write(data.data(), data.length());
     }
+    // the content itself is the output, so no message is printed out
+    Logger::setLastStatus(Logger::STATUS_OK);
 }
 
 void Disk::removeINodeFromParent(INode_t *iNode) {
@@ -826,37 +1948,45 @@ void Disk::removeINodeFromParent(INode_t *iNode) {
         LOG_ERR("The i-node is NULL");
         return;
     }
-    INode_t *parentINode = &iNodes[iNode->parentId];
-    DirectoryItems_t *parentDir = getDirectoryItemsFromINode(parentINode);
-    if (parentDir == NULL) {
-        LOG_ERR("The parent directory is NULL");
-        return;
-    }
-    size_t position = 0;
-    size_t index = 0;
+    removeItemFromDirectory(&iNodes[iNode->parentId], iNode, getNameOfINode(iNode));
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    iNodeNames[iNode->nodeId].clear();
+}
 
-    LOG_INFO("Finding an index of the file/folder within the directory");
-    for (size_t i = 0; i < parentDir->count; i++)
-        if (parentDir->items[i].iNode == iNode->nodeId) {
-            position = i;
-            break;
-        }
-    parentDir->count--;
-    LOG_INFO("Copying all items into the new directory except the file/folder");
-    DirectoryItem_t *newDirectoryItems = new DirectoryItem_t[parentDir->count];
-    for (size_t i = 0; i < parentDir->count + 1; i++)
-        if (i != position)
-            newDirectoryItems[index++] = parentDir->items[i];
+void Disk::removeItemFromDirectory(INode_t *parentINode, INode_t *iNode, std::string name) {
+    int32_t count = (parentINode->size - sizeof(size_t)) / sizeof(DirectoryItem_t);
+    int32_t position;
+    DirectoryItem_t item;
 
-    DirectoryItem_t *tmp = parentDir->items;
-    parentDir->items = newDirectoryItems;
-    parentINode->size = sizeof(size_t) + parentDir->count * sizeof(DirectoryItem_t);
+    LOG_INFO("Finding the position of the file/folder within the directory");
+    if (findInDirectory(parentINode, name, &position) != iNode->nodeId) {
+        LOG_ERR("The i-node is not in its parent directory");
+        return;
+    }
+    readFromDisk(&item, sizeof(DirectoryItem_t), 1, getDirectoryItemOffset(parentINode, position));
+    int32_t last = count - 1;
+    updateSubtreeUsage(parentINode, iNode, false);
+    updateDirectoryIndex(parentINode, item.itemName, position, NULL_POINTER);
+    cacheDentry(parentINode->nodeId, std::string(item.itemName, strnlen(item.itemName, FILE_NAME_LEN)), NULL_POINTER);
 
+    // the last item of the directory is moved into the
+    // slot of the removed one, so there are no gaps
+    if (position != last) {
+        DirectoryItem_t lastItem;
+        readFromDisk(&lastItem, sizeof(DirectoryItem_t), 1, getDirectoryItemOffset(parentINode, last));
+        saveDirectoryItemOnDisk(parentINode, position, &lastItem);
+        updateDirectoryIndex(parentINode, lastItem.itemName, last, position);
+    }
     LOG_INFO("Saving changes on the disk");
-    delete[] tmp;
-    saveDirectoryItemsOnDisk(parentINode, parentDir);
+    int32_t numberOfClusters = getNumberOfClustersOfINode(parentINode);
+    resizeDirectory(parentINode, count - 1);
+    saveNumberOfDirectoryItemsOnDisk(parentINode);
+
+    if (parentINode->directoryIndex != NULL_POINTER && count - 1 < DIR_INDEX_MIN_ITEMS / 2)
+        removeDirectoryIndex(parentINode);
     saveINodesOnDisk();
-    delete parentDir;
+    if (numberOfClusters != getNumberOfClustersOfINode(parentINode))
+        saveBitmapOnDisk();
 }
 
 void Disk::removeINode(INode_t *iNode) {
@@ -865,76 +1995,165 @@ void Disk::removeINode(INode_t *iNode) {
         LOG_ERR("The i-node is NULL");
         return;
     }
+    // an i-node with its content stored inline has no clusters
+    bool hasClusters = iNode->direct[0] != NULL_POINTER;
+
+    if (iNode->packOffset != NULL_POINTER) {
+        // the shared cluster is released only along with its last file
+        LOG_INFO("Releasing the space of the file within the shared cluster");
+        hasClusters = releasePackedSpace(iNode->direct[0], iNode->packOffset);
+        iNode->direct[0] = NULL_POINTER;
+        iNode->packOffset = NULL_POINTER;
+    }
+
     LOG_INFO("Deleting all clusters of the i-node");
     std::vector<int32_t> clusters = getAllClustersOfINode(iNode);
-    for (int32_t cluster : clusters)
-        bitmap[cluster] = true;
+
+    LOG_INFO("Deleting all indirect clusters of the i-node");
+    std::vector<int32_t> indirectClusters = getIndirectClustersOfINode(iNode);
+    clusters.insert(clusters.end(), indirectClusters.begin(), indirectClusters.end());
+
+    LOG_INFO("Deleting the cached names of the directory");
+    invalidateDentries(iNode->nodeId);
+
+    LOG_INFO("Deleting the index of the directory");
+    std::vector<int32_t> indexClusters = getIndexClustersOfINode(iNode);
+    clusters.insert(clusters.end(), indexClusters.begin(), indexClusters.end());
+    iNode->directoryIndex = NULL_POINTER;
 
     LOG_INFO("Deleting direct pointers");
     for (int i = 0; i < NUM_OF_DIRECT_POINTERS; i++) {
         if (iNode->direct[i] != NULL_POINTER) {
-            bitmap[iNode->direct[i]] = true;
+            clusters.push_back(iNode->direct[i]);
             iNode->direct[i] = NULL_POINTER;
         }
     }
     LOG_INFO("Deleting indirect pointers");
     for (int i = 0; i < NUM_OF_INDIRECT_POINTERS; i++) {
         if (iNode->indirect[i] != NULL_POINTER) {
-            bitmap[iNode->indirect[i]] = true;
+            clusters.push_back(iNode->indirect[i]);
             iNode->indirect[i] = NULL_POINTER;
         }
     }
+    releaseClusters(clusters);
+    if (iNode->nodeId == defragNextINodeId)
+        defragSourceRemoved = true;
     LOG_INFO("Resetting the i-node");
     iNode->parentId = NULL_POINTER;
     iNode->size = 0;
-    iNode->isFree = true;
     iNode->isDirectory = false;
     iNode->isSymbolicLink = false;
+    iNode->isInline = false;
+    iNode->subtreeSize = 0;
+    iNode->subtreeClusters = 0;
+    {
+        // the i-node can be claimed by another thread from now on
+        std::lock_guard<std::mutex> lock(allocationGroups[getAllocationGroupOfINode(iNode->nodeId)].mtx);
+        iNode->isFree = true;
+    }
 
     saveINodesOnDisk();
-    saveBitmapOnDisk();
+    if (hasClusters)
+        saveBitmapOnDisk();
 }
 
 void Disk::removeFile(INode_t *iNode) {
     LOG_INFO("Removing the file from the file system");
     if (iNode == NULL) {
-        USER_ALERT("FILE NOT FOUND");
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
         return;
     }
     if (iNode->isDirectory) {
-        USER_ALERT("TARGET IS NOT A FILE");
+        USER_ALERT(Logger::STATUS_NOT_A_FILE);
+        return;
+    }
+    SharedLock_t treeGuard(treeLock);
+    ExclusiveLock_t parentGuard;
+    ExclusiveLock_t iNodeGuard;
+    if (lockWithParent(iNode, parentGuard, iNodeGuard) == false) {
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
         return;
     }
     removeINodeFromParent(iNode);
     removeINode(iNode);
-    USER_ALERT("OK");
+    USER_ALERT(Logger::STATUS_OK);
 }
 
 void Disk::removeDirectory(INode_t *iNode) {
     LOG_INFO("Removing the directory from the file system");
     if (iNode == NULL) {
-        USER_ALERT("FILE NOT FOUND");
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
         return;
     }
     if (iNode->isDirectory == false) {
-        USER_ALERT("TARGET IS NOT A DIRECTORY");
+        USER_ALERT(Logger::STATUS_NOT_A_DIRECTORY);
         return;
     }
     if (iNode->nodeId == ROOT_INODE_ID) {
-        USER_ALERT("CANNOT REMOVE ROOT DIRECTORY");
+        USER_ALERT(Logger::STATUS_CANNOT_REMOVE_ROOT);
+        return;
+    }
+    SharedLock_t treeGuard(treeLock);
+    ExclusiveLock_t parentGuard;
+    ExclusiveLock_t iNodeGuard;
+    if (lockWithParent(iNode, parentGuard, iNodeGuard) == false) {
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
         return;
     }
     if (iNode->size != (sizeof(size_t) + 2 * sizeof(DirectoryItem_t))) {
-        USER_ALERT("NOT EMPTY");
+        USER_ALERT(Logger::STATUS_NOT_EMPTY);
+        return;
+    }
+    if (isWorkingDirectoryInSubtree(iNode)) {
+        USER_ALERT(Logger::STATUS_CANNOT_REMOVE_CURRENT);
+        return;
+    }
+    removeINodeFromParent(iNode);
+    removeINode(iNode);
+    USER_ALERT(Logger::STATUS_OK);
+}
+
+void Disk::removeDirectoryRecursively(INode_t *iNode) {
+    LOG_INFO("Removing the directory including its content from the file system");
+    if (iNode == NULL) {
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
+        return;
+    }
+    if (iNode->isDirectory == false) {
+        removeFile(iNode);
+        return;
+    }
+    if (iNode->nodeId == ROOT_INODE_ID) {
+        USER_ALERT(Logger::STATUS_CANNOT_REMOVE_ROOT);
+        return;
+    }
+    ExclusiveLock_t treeGuard(treeLock);
+    if (iNode->isFree) {
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
         return;
     }
-    if (iNode->nodeId == currentINode->nodeId) {
-        USER_ALERT("CANNOT REMOVE CURRENT DIRECTORY");
+    if (isWorkingDirectoryInSubtree(iNode)) {
+        USER_ALERT(Logger::STATUS_CANNOT_REMOVE_CURRENT);
         return;
     }
+    std::unordered_map<int32_t, std::vector<DirectoryItem_t>> tree = readDirectoryTree(iNode);
+
+    // the items of the removed directories do not need to be
+    // removed one by one as the directories are removed as a whole
+    beginBatch();
     removeINodeFromParent(iNode);
+    for (auto &directory : tree) {
+        for (auto &item : directory.second) {
+            {
+                std::lock_guard<std::mutex> lock(cacheMutex);
+                iNodeNames[item.iNode].clear();
+            }
+            removeINode(&iNodes[item.iNode]);
+        }
+    }
     removeINode(iNode);
-    USER_ALERT("OK");
+    commitBatch();
+    USER_ALERT(Logger::STATUS_OK);
 }
 
 Disk::INode_t *Disk::getINodeFromPath(std::string path) {
@@ -943,50 +2162,33 @@ Disk::INode_t *Disk::getINodeFromPath(std::string path) {
         LOG_ERR("The path is empty");
         return NULL;
     }
+    SharedLock_t treeGuard(treeLock);
     if (path == "/")
         return &iNodes[ROOT_INODE_ID];
     if (path == "." || path == "./")
-        return currentINode;
+        return getCurrentINode();
     if (path == ".." || path == "../")
-        return &iNodes[currentINode->parentId];
-    return getINodeFromPath(currentINode, path, path[0] != '/');
+        return &iNodes[getCurrentINode()->parentId];
+    return getINodeFromPath(getCurrentINode(), path, path[0] != '/');
 }
 
 Disk::INode_t *Disk::getINodeFromPath(INode_t *iNode, std::string path, bool relative) {
     LOG_INFO("Getting an i-node from the path (relative/absolute)");
-    DirectoryItems_t *dir = getDirectoryItemsFromINode(relative ? iNode : &iNodes[ROOT_INODE_ID]);
-    if (dir == NULL) {
-        LOG_ERR("The directory items is NULL");
-        return NULL;
-    }
+    INode_t *directoryINode = relative ? iNode : &iNodes[ROOT_INODE_ID];
     INode_t *targetINode = NULL;
-    bool found;
     std::vector<std::string> parts = split(path, '/');
 
     LOG_INFO("Starting going through the path to find the target i-node");
     for (int i = 0; i < (int)parts.size(); i++) {
-        found = false;
-        for (size_t j = 0; j < dir->count; j++) {
-            if (std::string(dir->items[j].itemName) == parts[i]) {
-                targetINode = &iNodes[dir->items[j].iNode];
-                if (i < (int)parts.size() - 1) {
-                    if (targetINode->isDirectory == false) {
-                        delete dir;
-                        return NULL;
-                    }
-                    delete dir;
-                    dir = getDirectoryItemsFromINode(targetINode);
-                }
-                found = true;
-                break;
-            }
-        }
-        if (found == false) {
-            delete dir;
+        SharedLock_t iNodeGuard(iNodeLocks[directoryINode->nodeId]);
+        if (directoryINode->isDirectory == false)
             return NULL;
-        }
+        int32_t iNodeId = lookupInDirectory(directoryINode, parts[i]);
+        if (iNodeId == NULL_POINTER)
+            return NULL;
+        targetINode = &iNodes[iNodeId];
+        directoryINode = targetINode;
     }
-    delete dir;
     return targetINode;
 }
 
@@ -1001,191 +2203,464 @@ std::vector<std::string> Disk::split(const std::string& str, char separator) {
 }
 
 void Disk::addNewFolder(std::string folderName) {
-    addNewFolder(currentINode, folderName);
+    addNewFolder(getCurrentINode(), folderName);
 }
 
 void Disk::addNewFolder(INode_t *destinationINode, std::string folderName) {
     LOG_INFO("Adding a new folder into the directory");
     if (destinationINode == NULL) {
-        USER_ALERT("PATH NOT FOUND");
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
         return;
     }
-    if (destinationINode->isDirectory == false) {
-        USER_ALERT("TARGET IS NOT A DIRECTORY");
+    SharedLock_t treeGuard(treeLock);
+    ExclusiveLock_t iNodeGuard(iNodeLocks[destinationINode->nodeId]);
+    if (destinationINode->isFree) {
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
         return;
     }
-    auto directory = std::unique_ptr<DirectoryItems_t>(getDirectoryItemsFromINode(destinationINode));
-    if (directory == NULL) {
-        LOG_ERR("Directory entries is NULL");
+    if (destinationINode->isDirectory == false) {
+        USER_ALERT(Logger::STATUS_NOT_A_DIRECTORY);
         return;
     }
-    if (existsInDirectory(directory.get(), folderName)) {
-        USER_ALERT("EXISTS");
+    if (existsInDirectory(destinationINode, folderName)) {
+        USER_ALERT(Logger::STATUS_EXISTS);
         return;
     }
-    INode_t *newFolderINode = getFreeINode();
+    if (createFolder(destinationINode, folderName) == NULL)
+        return;
+    USER_ALERT(Logger::STATUS_OK);
+}
+
+Disk::INode_t *Disk::createFolder(INode_t *destinationINode, std::string folderName) {
+    INode_t *newFolderINode = getFreeINode(destinationINode, true);
     if (newFolderINode == NULL) {
         LOG_ERR("All i-nodes are occupied");
-        return;
+        return NULL;
     }
-    newFolderINode->isDirectory = true;
-    newFolderINode->isFree = false;
-    addDirectClustersToINode(newFolderINode);
-    addINodeToDirectory(directory.get(), destinationINode, newFolderINode, folderName);
-
-    DirectoryItems_t *newDir = new DirectoryItems_t(newFolderINode->nodeId, destinationINode->nodeId);
-    newFolderINode->size = sizeof(size_t) + newDir->count * sizeof(DirectoryItem_t);
+    if (initFolder(newFolderINode, destinationINode, folderName) == false)
+        return NULL;
+    return newFolderINode;
+}
 
-    saveDirectoryItemsOnDisk(newFolderINode, newDir);
+bool Disk::initFolder(INode_t *newFolderINode, INode_t *destinationINode, std::string folderName) {
+    auto newDir = std::unique_ptr<DirectoryItems_t>(new DirectoryItems_t(newFolderINode->nodeId, destinationINode->nodeId));
+    newFolderINode->isDirectory = true;
+    if (resizeDirectory(newFolderINode, newDir->count) == false) {
+        LOG_ERR("There's not enough free clusters in the file system");
+        removeINode(newFolderINode);
+        return false;
+    }
+    if (addINodeToDirectory(destinationINode, newFolderINode, folderName) == false) {
+        removeINode(newFolderINode);
+        return false;
+    }
+    saveDirectoryItemsOnDisk(newFolderINode, newDir.get());
     saveINodesOnDisk();
     saveBitmapOnDisk();
-    delete newDir;
-    USER_ALERT("OK");
+    return true;
 }
 
 void Disk::moveFileToADifferentDir(INode_t *fileINode, INode_t *destinationINode, std::string fileName) {
     LOG_INFO("Moving file to a different directory");
     if (fileINode == NULL) {
-        USER_ALERT("FILE NOT FOUND");
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
         return;
     }
-    if (fileINode->isDirectory == true) {
-        USER_ALERT("CANNOT MOVE A DIRECTORY");
+    if (fileINode->nodeId == ROOT_INODE_ID) {
+        USER_ALERT(Logger::STATUS_CANNOT_MOVE_ROOT);
         return;
     }
     if (destinationINode == NULL) {
-        USER_ALERT("PATH NOT FOUND");
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
         return;
     }
     if (destinationINode->isDirectory == false) {
-        USER_ALERT("TARGET IS NOT A DIRECTORY");
+        USER_ALERT(Logger::STATUS_NOT_A_DIRECTORY);
         return;
     }
     if (fileName == "") {
         LOG_ERR("Name of the file is NULL");
         return;
     }
-    auto destinationDir = std::unique_ptr<DirectoryItems_t>(getDirectoryItemsFromINode(destinationINode));
-    if (destinationDir == NULL) {
-        LOG_ERR("Destination directory is NULL");
+
+    // a directory is moved under the exclusive lock of the tree, so no other operation
+    // is going through it. A file locks only its parent and the destination directory.
+    ExclusiveLock_t treeWriteGuard(treeLock, std::defer_lock);
+    SharedLock_t treeReadGuard(treeLock, std::defer_lock);
+    ExclusiveLock_t firstGuard;
+    ExclusiveLock_t secondGuard;
+    ExclusiveLock_t iNodeGuard;
+    if (fileINode->isDirectory)
+        treeWriteGuard.lock();
+    else {
+        treeReadGuard.lock();
+        int32_t parentId = fileINode->parentId;
+        if (parentId < 0 || parentId >= INODES_COUNT) {
+            USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
+            return;
+        }
+        // the directories are always locked in the order of their ids
+        firstGuard = ExclusiveLock_t(iNodeLocks[std::min(parentId, destinationINode->nodeId)]);
+        if (parentId != destinationINode->nodeId)
+            secondGuard = ExclusiveLock_t(iNodeLocks[std::max(parentId, destinationINode->nodeId)]);
+        iNodeGuard = ExclusiveLock_t(iNodeLocks[fileINode->nodeId]);
+        if (fileINode->parentId != parentId) {
+            USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
+            return;
+        }
+    }
+    if (fileINode->isFree) {
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
+        return;
+    }
+    if (destinationINode->isDirectory == false) {
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
+        return;
+    }
+    if (existsInDirectory(destinationINode, fileName)) {
+        USER_ALERT(Logger::STATUS_EXISTS);
         return;
     }
-    if (existsInDirectory(destinationDir.get(), fileName)) {
-        USER_ALERT("EXISTS");
+    if (fileINode->isDirectory && isInSubtree(destinationINode, fileINode)) {
+        USER_ALERT(Logger::STATUS_CANNOT_MOVE_INTO_ITSELF);
         return;
     }
 
-    removeINodeFromParent(fileINode);
-    destinationDir = std::unique_ptr<DirectoryItems_t>(getDirectoryItemsFromINode(destinationINode));
-    addINodeToDirectory(destinationDir.get(), destinationINode, fileINode, fileName);
-    saveINodesOnDisk();
-    USER_ALERT("OK");
-}
+    // the item is added into the destination before it's removed from its
+    // parent, so it's never left outside the tree if the destination cannot grow
+    INode_t *parentINode = &iNodes[fileINode->parentId];
+    std::string name = getNameOfINode(fileINode);
+    if (addINodeToDirectory(destinationINode, fileINode, fileName) == false) {
+        LOG_ERR("The file cannot be added into the destination directory");
+        USER_ALERT(Logger::STATUS_FAILED);
+        return;
+    }
+    removeItemFromDirectory(parentINode, fileINode, name);
+    if (fileINode->isDirectory) {
+        LOG_INFO("Updating the parent of the moved directory");
+        DirectoryItem_t parentItem = {};
+        parentItem.iNode = destinationINode->nodeId;
+        parentItem.type = ITEM_DIRECTORY;
+        strcpy(parentItem.itemName, "..");
+        saveDirectoryItemOnDisk(fileINode, 1, &parentItem);
+        cacheDentry(fileINode->nodeId, "..", destinationINode->nodeId);
+    }
+    saveINodesOnDisk();
+    USER_ALERT(Logger::STATUS_OK);
+}
 
 void Disk::cd(std::string path) {
     LOG_INFO("Changing the current directory");
     INode_t *iNode = getINodeFromPath(path);
     if (iNode == NULL) {
-        USER_ALERT("PATH NOT FOUND");
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
         return;
     }
+    SharedLock_t treeGuard(treeLock);
+    SharedLock_t iNodeGuard(iNodeLocks[iNode->nodeId]);
     if (iNode->isDirectory == false) {
-        USER_ALERT("TARGET IS NOT A DIRECTORY");
+        USER_ALERT(Logger::STATUS_NOT_A_DIRECTORY);
         return;
     }
-    currentINode = iNode;
-    USER_ALERT("OK");
+    setCurrentINode(iNode);
+    USER_ALERT(Logger::STATUS_OK);
+}
+
+void Disk::closeSession() {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    workingDirectories.erase(std::this_thread::get_id());
+}
+
+int32_t Disk::getWorkingDirectory() {
+    return getCurrentINode()->nodeId;
+}
+
+void Disk::setWorkingDirectory(int32_t directoryId) {
+    SharedLock_t treeGuard(treeLock);
+    if (directoryId < 0 || directoryId >= INODES_COUNT) {
+        closeSession();
+        return;
+    }
+    INode_t *iNode = &iNodes[directoryId];
+    SharedLock_t iNodeGuard(iNodeLocks[iNode->nodeId]);
+    if (iNode->isFree || iNode->isDirectory == false) {
+        closeSession();
+        return;
+    }
+    setCurrentINode(iNode);
+}
+
+Disk::INode_t *Disk::getCurrentINode() {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    auto session = workingDirectories.find(std::this_thread::get_id());
+    if (session == workingDirectories.end())
+        return &iNodes[ROOT_INODE_ID];
+    return &iNodes[session->second];
+}
+
+void Disk::setCurrentINode(INode_t *iNode) {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    workingDirectories[std::this_thread::get_id()] = iNode->nodeId;
+}
+
+bool Disk::isWorkingDirectoryInSubtree(INode_t *directoryINode) {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    for (auto &session : workingDirectories)
+        if (isInSubtree(&iNodes[session.second], directoryINode))
+            return true;
+    return false;
+}
+
+bool Disk::lockWithParent(INode_t *iNode, ExclusiveLock_t &parentLock, ExclusiveLock_t &lock) {
+    int32_t parentId = iNode->parentId;
+    if (parentId < 0 || parentId >= INODES_COUNT || parentId == iNode->nodeId)
+        return false;
+
+    // the directories are always locked in the order of their ids (the same way as
+    // when a file is moved), and a file is always locked after its directories
+    if (iNode->isDirectory && iNode->nodeId < parentId) {
+        lock = ExclusiveLock_t(iNodeLocks[iNode->nodeId]);
+        parentLock = ExclusiveLock_t(iNodeLocks[parentId]);
+    } else {
+        parentLock = ExclusiveLock_t(iNodeLocks[parentId]);
+        lock = ExclusiveLock_t(iNodeLocks[iNode->nodeId]);
+    }
+    return iNode->isFree == false && iNode->parentId == parentId;
 }
 
 void Disk::copyFileToADifferentDirectory(INode_t *fileINode, INode_t *destinationINode, std::string fileName) {
     LOG_INFO("Starting copying the file to the different directory");
     if (fileINode == NULL) {
-        USER_ALERT("FILE NOT FOUND");
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
         return;
     }
     if (destinationINode == NULL) {
-        USER_ALERT("PATH NOT FOUND");
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
         return;
     }
     if (fileINode->isDirectory == true) {
-        USER_ALERT("CANNOT COPY A DIRECTORY");
+        USER_ALERT(Logger::STATUS_CANNOT_COPY_DIRECTORY);
         return;
     }
     if (destinationINode->isDirectory == false) {
-        USER_ALERT("TARGET IS NOT A DIRECTORY");
+        USER_ALERT(Logger::STATUS_NOT_A_DIRECTORY);
         return;
     }
     if (fileName == "") {
         LOG_ERR("The Name of the file is NULL");
         return;
     }
-    auto destinationDir = std::unique_ptr<DirectoryItems_t>(getDirectoryItemsFromINode(destinationINode));
-    if (destinationDir == NULL) {
-        LOG_ERR("The destination directory is NULL");
+    SharedLock_t treeGuard(treeLock);
+    ExclusiveLock_t destinationGuard(iNodeLocks[destinationINode->nodeId]);
+    SharedLock_t iNodeGuard(iNodeLocks[fileINode->nodeId]);
+    if (fileINode->isFree) {
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
         return;
     }
-    if (existsInDirectory(destinationDir.get(), fileName)) {
-        USER_ALERT("EXISTS");
+    if (destinationINode->isDirectory == false) {
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
         return;
     }
-    INode_t *newFileINode = getFreeINode();
-    if (newFileINode == NULL) {
-        LOG_ERR("All i-nodes are occupied");
+    if (existsInDirectory(destinationINode, fileName)) {
+        USER_ALERT(Logger::STATUS_EXISTS);
         return;
     }
-    std::vector<int32_t> clustersToCopy = getAllClustersOfINode(fileINode);
+    std::vector<std::pair<int32_t, int32_t>> clusterCopies;
+    INode_t *newFileINode = copyINode(fileINode, destinationINode, clusterCopies);
+    if (newFileINode == NULL)
+        return;
 
-    if (isThereAtLeastNFreeClusters(clustersToCopy.size()) == false) {
-        LOG_ERR("There is not enough free clusters in the file system");
+    // the content is copied before the copy is added into the
+    // directory, so the copy is never seen without its content
+    copyClusters(clusterCopies);
+    if (addINodeToDirectory(destinationINode, newFileINode, fileName) == false) {
+        removeINode(newFileINode);
         return;
     }
+    if (clusterCopies.empty() == false)
+        saveBitmapOnDisk();
+    saveINodesOnDisk();
+    USER_ALERT(Logger::STATUS_OK);
+}
 
-    LOG_INFO("copying clusters");
-    std::vector<int32_t> newClusters;
-    char *buff = new char[superBlock->clusterSize + 1];
+Disk::INode_t *Disk::copyINode(INode_t *fileINode, INode_t *destinationINode, std::vector<std::pair<int32_t, int32_t>> &clusterCopies) {
+    INode_t *newFileINode = getFreeINode(destinationINode);
+    if (newFileINode == NULL) {
+        LOG_ERR("All i-nodes are occupied");
+        return NULL;
+    }
+    if (fileINode->packOffset != NULL_POINTER) {
+        LOG_INFO("Copying the content stored in a shared cluster");
+        newFileINode->size = fileINode->size;
+        newFileINode->isDirectory = false;
+        newFileINode->isSymbolicLink = fileINode->isSymbolicLink;
+        if (storePackedContent(newFileINode, getPackedContent(fileINode).data()) == false) {
+            removeINode(newFileINode);
+            return NULL;
+        }
+        return newFileINode;
+    }
+    std::vector<int32_t> clustersToCopy = getAllClustersOfINode(fileINode);
 
-    for (int i = 0; i < (int)clustersToCopy.size(); i++) {
-        newClusters.push_back(getFreeCluster());
-        fseek(diskFile, dataOffset(clustersToCopy[i]), SEEK_SET);
-        fread(buff, sizeof(char), superBlock->clusterSize, diskFile);
-        fseek(diskFile, dataOffset(newClusters[i]), SEEK_SET);
-        fwrite(buff, sizeof(char), superBlock->clusterSize, diskFile);
+    LOG_INFO("Allocating clusters of the copy");
+    std::vector<int32_t> newClusters = getFreeClusters(clustersToCopy.size(), newFileINode);
+    if (newClusters.size() != clustersToCopy.size()) {
+        LOG_ERR("There is not enough free clusters in the file system");
+        removeINode(newFileINode);
+        return NULL;
     }
-    fflush(diskFile);
 
     newFileINode->isDirectory = false;
-    newFileINode->isFree = false;
     newFileINode->size = fileINode->size;
     newFileINode->isSymbolicLink = fileINode->isSymbolicLink;
-    addINodeToDirectory(destinationDir.get(), destinationINode, newFileINode, fileName);
-
+    newFileINode->isInline = fileINode->isInline;
+    memcpy(newFileINode->inlineData, fileINode->inlineData, sizeof(fileINode->inlineData));
     if (attachClustersToINode(newFileINode, newClusters) == false) {
         LOG_ERR("Attaching clusters to the i-node failed");
+        releaseClusters(newClusters);
+        removeINode(newFileINode);
+        return NULL;
+    }
+    for (int i = 0; i < (int)clustersToCopy.size(); i++)
+        clusterCopies.emplace_back(clustersToCopy[i], newClusters[i]);
+    return newFileINode;
+}
+
+void Disk::copyDirectoryToADifferentDirectory(INode_t *directoryINode, INode_t *destinationINode, std::string directoryName) {
+    LOG_INFO("Starting copying the directory to the different directory");
+    if (directoryINode == NULL) {
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
         return;
     }
-    delete[] buff;
-    saveBitmapOnDisk();
-    saveINodesOnDisk();
-    USER_ALERT("OK");
+    if (destinationINode == NULL) {
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
+        return;
+    }
+    if (directoryINode->isDirectory == false) {
+        copyFileToADifferentDirectory(directoryINode, destinationINode, directoryName);
+        return;
+    }
+    if (destinationINode->isDirectory == false) {
+        USER_ALERT(Logger::STATUS_NOT_A_DIRECTORY);
+        return;
+    }
+    if (directoryName == "") {
+        LOG_ERR("The Name of the directory is NULL");
+        return;
+    }
+    ExclusiveLock_t treeGuard(treeLock);
+    if (directoryINode->isFree || destinationINode->isFree) {
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
+        return;
+    }
+    if (existsInDirectory(destinationINode, directoryName)) {
+        USER_ALERT(Logger::STATUS_EXISTS);
+        return;
+    }
+    if (isInSubtree(destinationINode, directoryINode)) {
+        USER_ALERT(Logger::STATUS_CANNOT_COPY_INTO_ITSELF);
+        return;
+    }
+    std::unordered_map<int32_t, std::vector<DirectoryItem_t>> tree = readDirectoryTree(directoryINode);
+    std::vector<std::pair<int32_t, int32_t>> clusterCopies;
+    std::vector<CopiedFile_t> copiedFiles;
+
+    // the content is copied before the files are added into their directories
+    // and the metadata is stored, so the copies never point at uninitialized clusters
+    beginBatch();
+    bool copied = copyTree(directoryINode, destinationINode, directoryName, tree, clusterCopies, copiedFiles);
+    copyClusters(clusterCopies);
+    for (auto &file : copiedFiles) {
+        if (addINodeToDirectory(file.directoryINode, file.iNode, file.name) == false) {
+            removeINode(file.iNode);
+            copied = false;
+        }
+    }
+    commitBatch();
+    if (copied == false) {
+        LOG_ERR("The directory has not been copied completely");
+        return;
+    }
+    USER_ALERT(Logger::STATUS_OK);
+}
+
+bool Disk::copyTree(INode_t *iNode, INode_t *destinationINode, std::string name, const std::unordered_map<int32_t, std::vector<DirectoryItem_t>> &tree,
+                    std::vector<std::pair<int32_t, int32_t>> &clusterCopies, std::vector<CopiedFile_t> &copiedFiles) {
+    if (iNode->isDirectory == false) {
+        INode_t *newFileINode = copyINode(iNode, destinationINode, clusterCopies);
+        if (newFileINode == NULL)
+            return false;
+        copiedFiles.push_back({newFileINode, destinationINode, name});
+        return true;
+    }
+
+    INode_t *newFolderINode = createFolder(destinationINode, name);
+    if (newFolderINode == NULL)
+        return false;
+    auto directory = tree.find(iNode->nodeId);
+    if (directory == tree.end())
+        return true;
+    for (auto &item : directory->second)
+        if (copyTree(&iNodes[item.iNode], newFolderINode, std::string(item.itemName, strnlen(item.itemName, FILE_NAME_LEN)), tree, clusterCopies, copiedFiles) == false)
+            return false;
+    return true;
+}
+
+void Disk::copyClusters(std::vector<std::pair<int32_t, int32_t>> clusterCopies) {
+    LOG_INFO("Copying the content of the clusters");
+    std::sort(clusterCopies.begin(), clusterCopies.end());
+
+    // runs of consecutive source clusters going into consecutive destination clusters
+    std::vector<std::pair<size_t, size_t>> runs;
+    for (size_t first = 0; first < clusterCopies.size();) {
+        size_t last = first + 1;
+        while (last < clusterCopies.size() && last - first < COPY_RUN_LEN &&
+               clusterCopies[last].first == clusterCopies[last - 1].first + 1 &&
+               clusterCopies[last].second == clusterCopies[last - 1].second + 1)
+            last++;
+        runs.emplace_back(first, last);
+        first = last;
+    }
+    auto copyRun = [this, &clusterCopies](size_t first, size_t last) {
+        size_t length = (last - first) * superBlock->clusterSize;
+        auto buff = std::unique_ptr<char[]>(new char[length]);
+        readFromDisk(buff.get(), sizeof(char), length, dataOffset(clusterCopies[first].first));
+        writeToDisk(buff.get(), sizeof(char), length, dataOffset(clusterCopies[first].second));
+    };
+    if (runs.size() <= 1) {
+        for (auto &run : runs)
+            copyRun(run.first, run.second);
+        return;
+    }
+    ThreadPool::Batch tasks;
+    for (auto &run : runs)
+        threadPool.addTask(std::bind(copyRun, run.first, run.second), tasks);
+    threadPool.wait(tasks);
 }
 
 void Disk::printInfoAboutINode(INode_t *iNode) {
     LOG_INFO("Printing info about the i-node");
     if (iNode == NULL) {
-        USER_ALERT("FILE NOT FOUND");
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
+        return;
+    }
+    SharedLock_t treeGuard(treeLock);
+    SharedLock_t iNodeGuard(iNodeLocks[iNode->nodeId]);
+    if (iNode->isFree) {
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
         return;
     }
     printINode(iNode);
-    std::cout << "clusters:  [";
+    Logger::getOutput() << "clusters:  [";
     if (iNode->isDirectory == false) {
         std::vector<int32_t> clusters = getAllClustersOfINode(iNode);
         for (int i = 0; i < (int)clusters.size(); i++) {
-            std::cout << clusters[i];
+            Logger::getOutput() << clusters[i];
             if (i < (int)clusters.size() - 1)
-                std::cout << " ";
+                Logger::getOutput() << " ";
         }
     }
-    std::cout << "]\n";
+    Logger::getOutput() << "]\n";
 }
 
 std::string Disk::getPath(INode_t *iNode) {
@@ -1194,21 +2669,13 @@ std::string Disk::getPath(INode_t *iNode) {
         LOG_ERR("The i-node is NULL");
     }
 
-    INode_t *parent;
-    DirectoryItems_t* directoryItems;
     std::stack<std::string> st;
-
-    while (iNode->parentId != iNode->nodeId) {
-        parent = &iNodes[iNode->parentId];
-        directoryItems = getDirectoryItemsFromINode(parent);
-
-        for (size_t i = 0; i < directoryItems->count; i++)
-            if (directoryItems->items[i].iNode == iNode->nodeId) {
-                st.push(std::string(directoryItems->items[i].itemName));
-                break;
-            }
-        delete directoryItems;
-        iNode = parent;
+    while (iNode->parentId != iNode->nodeId && iNode->parentId >= 0 && iNode->parentId < INODES_COUNT) {
+        {
+            SharedLock_t iNodeGuard(iNodeLocks[iNode->parentId]);
+            st.push(getNameOfINode(iNode));
+        }
+        iNode = &iNodes[iNode->parentId];
     }
     std::stringstream path;
     path << "/";
@@ -1219,69 +2686,1200 @@ std::string Disk::getPath(INode_t *iNode) {
     return path.str();
 }
 
+std::string Disk::getNameOfINode(INode_t *iNode) {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        if (iNodeNames[iNode->nodeId].empty() == false)
+            return iNodeNames[iNode->nodeId];
+    }
+
+    LOG_INFO("Finding the name of the i-node in its parent directory");
+    std::string name;
+    DirectoryItem_t item;
+    DirectoryIterator it = readDirectory(&iNodes[iNode->parentId]);
+    while (it.next(&item))
+        if (item.iNode == iNode->nodeId && it.getPosition() >= 2) {
+            name = std::string(item.itemName, strnlen(item.itemName, FILE_NAME_LEN));
+            break;
+        }
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    iNodeNames[iNode->nodeId] = name;
+    return name;
+}
+
 void Disk::createSymbolicLink(INode_t *fileINode, std::string slinkName) {
     LOG_INFO("Creating a new symbolic link");
     if (fileINode == NULL) {
-        USER_ALERT("FILE NOT FOUND");
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
         return;
     }
     if (fileINode->isDirectory) {
-        USER_ALERT("TARGET IS NOT A FILE");
+        USER_ALERT(Logger::STATUS_NOT_A_FILE);
         return;
     }
     slinkName = normalizeName(slinkName);
-    auto directoryItems = std::unique_ptr<DirectoryItems_t>(getDirectoryItemsFromINode(currentINode));
-    if (directoryItems == NULL) {
-        LOG_ERR("The directory items is NULL");
-        return;
-    }
-    if (existsInDirectory(directoryItems.get(), slinkName)) {
-        USER_ALERT("EXISTS");
+    SharedLock_t treeGuard(treeLock);
+
+    // the path is put together before the current directory is locked
+    // as the directories along the path are locked meanwhile
+    std::string content = getPath(fileINode);
+    content.pop_back();
+    INode_t *directoryINode = getCurrentINode();
+    ExclusiveLock_t iNodeGuard(iNodeLocks[directoryINode->nodeId]);
+    if (existsInDirectory(directoryINode, slinkName)) {
+        USER_ALERT(Logger::STATUS_EXISTS);
         return;
     }
-    INode_t *linkINode = getFreeINode();
+    INode_t *linkINode = getFreeINode(directoryINode);
     if (linkINode == NULL) {
         LOG_ERR("All i-nodes are occupied");
         return;
     }
 
     LOG_INFO("Changing the parameters of the i-node");
-    std::string content = getPath(fileINode);
-    content.pop_back();
     linkINode->isDirectory = false;
-    linkINode->isFree = false;
     linkINode->isSymbolicLink = true;
     linkINode->size = content.length();
-    addINodeToDirectory(directoryItems.get(), currentINode, linkINode, slinkName);
+    linkINode->isInline = content.length() <= INLINE_DATA_LEN;
+    if (linkINode->isInline) {
+        // a short path is stored right in the i-node, so
+        // following the link costs no extra cluster
+        LOG_INFO("Storing the path in the i-node");
+        memcpy(linkINode->inlineData, content.c_str(), content.length());
+        if (addINodeToDirectory(directoryINode, linkINode, slinkName) == false) {
+            removeINode(linkINode);
+            return;
+        }
+        USER_ALERT(Logger::STATUS_OK);
+        return;
+    }
 
     LOG_INFO("Preparing clusters");
     int32_t numberOfClustersNeeded = getNumberOfClustersNeeded(content.length());
-    if (isThereAtLeastNFreeClusters(numberOfClustersNeeded) == false) {
+    std::vector<int32_t> clusters = getFreeClusters(numberOfClustersNeeded, linkINode);
+    if ((int32_t)clusters.size() != numberOfClustersNeeded) {
         LOG_ERR("There's not enough free clusters in the file system");
+        removeINode(linkINode);
         return;
     }
-    auto buff = std::unique_ptr<char[]>(new char[content.length()]);
-    for (size_t i = 0; i < content.length(); i++)
-        buff[i] = content[i];
-
-    std::vector<int32_t> clusters;
     int32_t remainingSize = content.length();
 
     LOG_INFO("Storing data on the disk");
     for (int i = 0; i < numberOfClustersNeeded; i++) {
-        clusters.push_back(getFreeCluster());
-        fseek(diskFile, dataOffset(clusters[i]), SEEK_SET);
-        if (remainingSize >= superBlock->clusterSize)
-            fwrite(buff.get(), sizeof(char), superBlock->clusterSize, diskFile);
-        else fwrite(buff.get(), sizeof(char), remainingSize, diskFile);
+        writeToDisk(content.data() + i * superBlock->clusterSize, sizeof(char), std::min(remainingSize, superBlock->clusterSize), dataOffset(clusters[i]));
         remainingSize -= superBlock->clusterSize;
     }
     if (attachClustersToINode(linkINode, clusters) == false) {
         LOG_ERR("Attaching clusters to the i-node failed");
+        releaseClusters(clusters);
+        removeINode(linkINode);
+        return;
+    }
+    if (addINodeToDirectory(directoryINode, linkINode, slinkName) == false) {
+        removeINode(linkINode);
         return;
     }
-    fflush(diskFile);
     saveBitmapOnDisk();
     saveINodesOnDisk();
-    USER_ALERT("OK");
+    USER_ALERT(Logger::STATUS_OK);
+}
+
+void Disk::readFromDisk(void *buff, size_t size, size_t count, off_t offset) {
+    size_t total = size * count;
+    size_t done = 0;
+    while (done < total) {
+        ssize_t n = pread(fileno(diskFile), (char *)buff + done, total - done, offset + done);
+        if (n <= 0) {
+            LOG_ERR("Reading from the disk failed");
+            memset((char *)buff + done, 0, total - done);
+            return;
+        }
+        done += n;
+    }
+}
+
+void Disk::writeToDisk(const void *buff, size_t size, size_t count, off_t offset) {
+    size_t total = size * count;
+    size_t done = 0;
+    while (done < total) {
+        ssize_t n = pwrite(fileno(diskFile), (const char *)buff + done, total - done, offset + done);
+        if (n <= 0) {
+            LOG_ERR("Writing into the disk failed");
+            return;
+        }
+        done += n;
+    }
+}
+
+void Disk::beginBatch() {
+    batch = true;
+    iNodesChanged = false;
+    bitmapChanged = false;
+}
+
+void Disk::commitBatch() {
+    batch = false;
+    if (iNodesChanged)
+        saveINodesOnDisk();
+    if (bitmapChanged)
+        saveBitmapOnDisk();
+}
+
+std::unordered_map<int32_t, std::vector<Disk::DirectoryItem_t>> Disk::readDirectoryTree(INode_t *directoryINode) {
+    LOG_INFO("Reading the directory tree in parallel");
+    std::unordered_map<int32_t, std::vector<DirectoryItem_t>> tree;
+    std::mutex mtx;
+    ThreadPool::Batch tasks;
+
+    std::function<void(int32_t)> readItems = [this, &tree, &mtx, &tasks, &readItems](int32_t directoryId) {
+        std::vector<DirectoryItem_t> items;
+        DirectoryItem_t item;
+        SharedLock_t iNodeGuard(iNodeLocks[directoryId]);
+        DirectoryIterator it = readDirectory(&iNodes[directoryId]);
+        while (it.next(&item)) {
+            if (it.getPosition() < 2 || item.iNode < 0 || item.iNode >= INODES_COUNT)
+                continue;
+            items.push_back(item);
+            if (iNodes[item.iNode].isDirectory) {
+                int32_t subdirectoryId = item.iNode;
+                if (isValidCluster(iNodes[subdirectoryId].direct[0]))
+                    posix_fadvise(fileno(diskFile), dataOffset(iNodes[subdirectoryId].direct[0]), superBlock->clusterSize, POSIX_FADV_WILLNEED);
+                threadPool.addTask([&readItems, subdirectoryId]() {
+                    readItems(subdirectoryId);
+                }, tasks);
+            }
+        }
+        iNodeGuard.unlock();
+        std::unique_lock<std::mutex> lock(mtx);
+        tree[directoryId] = std::move(items);
+    };
+    threadPool.addTask([&readItems, directoryINode]() {
+        readItems(directoryINode->nodeId);
+    }, tasks);
+    threadPool.wait(tasks);
+    return tree;
+}
+
+bool Disk::isValidCluster(int32_t cluster) const {
+    return cluster >= 0 && cluster < CLUSTER_COUNT;
+}
+
+std::vector<int32_t> Disk::getIndirectClustersOfINode(INode_t *iNode) {
+    LOG_INFO("Getting indirect clusters of the i-node");
+    std::vector<int32_t> clusters;
+    if (iNode == NULL) {
+        LOG_ERR("The i-node is NULL");
+        return clusters;
+    }
+    for (int i = 0; i < NUM_OF_INDIRECT_POINTERS; i++)
+        if (iNode->indirect[i] != NULL_POINTER)
+            clusters.push_back(iNode->indirect[i]);
+
+    if (iNode->indirect[1] == NULL_POINTER)
+        return clusters;
+
+    int32_t numberOfPointersInCluster = superBlock->clusterSize / sizeof(int32_t);
+    int32_t numberOfClustersNeeded = getNumberOfClustersOfINode(iNode) - NUM_OF_DIRECT_POINTERS - numberOfPointersInCluster;
+    if (numberOfClustersNeeded <= 0)
+        return clusters;
+
+    int32_t numberOfMiddleClusters = numberOfClustersNeeded / numberOfPointersInCluster;
+    if (numberOfClustersNeeded % numberOfPointersInCluster != 0)
+        numberOfMiddleClusters++;
+    numberOfMiddleClusters = std::min(numberOfMiddleClusters, numberOfPointersInCluster);
+
+    LOG_INFO("Getting the middle clusters");
+    std::vector<int32_t> middleClusters(numberOfMiddleClusters);
+    readFromDisk(middleClusters.data(), sizeof(int32_t), numberOfMiddleClusters, dataOffset(iNode->indirect[1]));
+    clusters.insert(clusters.end(), middleClusters.begin(), middleClusters.end());
+    return clusters;
+}
+
+void Disk::checkINode(INode_t *iNode, CheckedINode_t &checked) {
+    if (iNode->isFree)
+        return;
+
+    std::string prefix = "i-node " + std::to_string(iNode->nodeId) + ": ";
+    if (iNode->parentId < 0 || iNode->parentId >= INODES_COUNT) {
+        checked.problems.push_back(prefix + "invalid parent id " + std::to_string(iNode->parentId));
+        return;
+    }
+    if (iNode->nodeId == ROOT_INODE_ID && iNode->parentId != ROOT_INODE_ID)
+        checked.problems.push_back(prefix + "the root directory is not its own parent");
+
+    int32_t numberOfPointersInCluster = superBlock->clusterSize / sizeof(int32_t);
+    int64_t maxNumberOfClusters = NUM_OF_DIRECT_POINTERS + numberOfPointersInCluster + (int64_t)numberOfPointersInCluster * numberOfPointersInCluster;
+    if (iNode->size < 0 || getNumberOfClustersNeeded(iNode->size) > maxNumberOfClusters) {
+        checked.problems.push_back(prefix + "invalid size " + std::to_string(iNode->size));
+        return;
+    }
+    if (iNode->isInline && (iNode->size > INLINE_DATA_LEN || iNode->isDirectory || iNode->direct[0] != NULL_POINTER)) {
+        checked.problems.push_back(prefix + "invalid inline data (size " + std::to_string(iNode->size) + ")");
+        return;
+    }
+    if (iNode->packOffset != NULL_POINTER && (iNode->packOffset < 0 || iNode->packOffset + iNode->size > superBlock->clusterSize ||
+                                              iNode->isDirectory || iNode->isInline || iNode->direct[1] != NULL_POINTER)) {
+        checked.problems.push_back(prefix + "invalid offset within the shared cluster " + std::to_string(iNode->packOffset));
+        return;
+    }
+
+    LOG_INFO("Checking the indirect clusters of the i-node");
+    for (int i = 0; i < NUM_OF_INDIRECT_POINTERS; i++)
+        if (iNode->indirect[i] != NULL_POINTER && isValidCluster(iNode->indirect[i]) == false) {
+            checked.problems.push_back(prefix + "invalid indirect pointer " + std::to_string(iNode->indirect[i]));
+            return;
+        }
+    std::vector<int32_t> indirectClusters = getIndirectClustersOfINode(iNode);
+    for (int32_t cluster : indirectClusters)
+        if (isValidCluster(cluster) == false) {
+            checked.problems.push_back(prefix + "invalid indirect cluster " + std::to_string(cluster));
+            return;
+        }
+
+    LOG_INFO("Checking the data clusters of the i-node");
+    std::vector<int32_t> clusters = getAllClustersOfINode(iNode);
+    for (int32_t cluster : clusters)
+        if (isValidCluster(cluster) == false) {
+            checked.problems.push_back(prefix + "invalid cluster " + std::to_string(cluster));
+            return;
+        }
+    if ((int32_t)clusters.size() < getNumberOfClustersOfINode(iNode))
+        checked.problems.push_back(prefix + "missing clusters (" + std::to_string(clusters.size()) + " out of " +
+                                   std::to_string(getNumberOfClustersOfINode(iNode)) + ")");
+
+    checked.clusters = clusters;
+    checked.clusters.insert(checked.clusters.end(), indirectClusters.begin(), indirectClusters.end());
+
+    LOG_INFO("Checking the clusters of the index of the directory");
+    if (iNode->directoryIndex != NULL_POINTER) {
+        if (iNode->isDirectory == false || isValidCluster(iNode->directoryIndex) == false) {
+            checked.problems.push_back(prefix + "invalid index " + std::to_string(iNode->directoryIndex));
+            return;
+        }
+        std::vector<int32_t> indexClusters = getIndexClustersOfINode(iNode);
+        for (int32_t cluster : indexClusters)
+            if (isValidCluster(cluster) == false) {
+                checked.problems.push_back(prefix + "invalid index cluster " + std::to_string(cluster));
+                return;
+            }
+        checked.clusters.insert(checked.clusters.end(), indexClusters.begin(), indexClusters.end());
+    }
+
+    if (iNode->isDirectory == false)
+        return;
+
+    LOG_INFO("Checking the items of the directory");
+    int64_t itemsSize = iNode->size - (int64_t)sizeof(size_t);
+    if (itemsSize < 2 * (int64_t)sizeof(DirectoryItem_t) || itemsSize % sizeof(DirectoryItem_t) != 0 || clusters.empty()) {
+        checked.problems.push_back(prefix + "invalid size of the directory " + std::to_string(iNode->size));
+        return;
+    }
+    size_t count;
+    readFromDisk(&count, sizeof(size_t), 1, dataOffset(iNode->direct[0]));
+    if (count != (size_t)(itemsSize / sizeof(DirectoryItem_t))) {
+        checked.problems.push_back(prefix + "the number of items does not match the size of the directory");
+        return;
+    }
+    DirectoryItem_t item;
+    DirectoryIterator it = readDirectory(iNode);
+    while (it.next(&item))
+        checked.items.push_back(item);
+    if (checked.items[0].iNode != iNode->nodeId || std::string(checked.items[0].itemName) != ".")
+        checked.problems.push_back(prefix + "invalid item '.'");
+    if (checked.items[1].iNode != iNode->parentId || std::string(checked.items[1].itemName) != "..")
+        checked.problems.push_back(prefix + "invalid item '..'");
+}
+
+void Disk::checkFileSystem(bool repair) {
+    LOG_INFO("Checking the consistency of the file system");
+    ExclusiveLock_t treeGuard(treeLock);
+    returnCachedClusters();
+
+    // the run a file is being copied into by the defragmentation is
+    // not referenced by any i-node yet, so it would be reported as lost
+    cancelRelocation();
+    std::vector<CheckedINode_t> checked(INODES_COUNT);
+
+    LOG_INFO("Checking the i-nodes in parallel");
+    {
+        ThreadPool::Batch tasks;
+        int32_t rangeSize = std::max(1, (int32_t)(INODES_COUNT / (threadPool.size() * 4)));
+        for (int32_t first = 0; first < INODES_COUNT; first += rangeSize) {
+            int32_t last = std::min(first + rangeSize, INODES_COUNT);
+            threadPool.addTask([this, &checked, first, last]() {
+                for (int32_t i = first; i < last; i++)
+                    checkINode(&iNodes[i], checked[i]);
+            }, tasks);
+        }
+        threadPool.wait(tasks);
+    }
+    std::vector<std::string> problems;
+    for (auto &iNode : checked)
+        problems.insert(problems.end(), iNode.problems.begin(), iNode.problems.end());
+
+    LOG_INFO("Walking the directory tree from the root directory");
+    std::vector<bool> reachable(INODES_COUNT, false);
+    std::vector<int32_t> linkedBy(INODES_COUNT, NULL_POINTER);
+    std::vector<int32_t> discovered;
+    std::queue<int32_t> directories;
+    reachable[ROOT_INODE_ID] = true;
+    directories.push(ROOT_INODE_ID);
+
+    while (!directories.empty()) {
+        int32_t directory = directories.front();
+        directories.pop();
+        for (size_t i = 2; i < checked[directory].items.size(); i++) {
+            const DirectoryItem_t &item = checked[directory].items[i];
+            std::string prefix = "directory " + std::to_string(directory) + ": item '" + std::string(item.itemName) + "' ";
+            if (item.iNode < 0 || item.iNode >= INODES_COUNT || iNodes[item.iNode].isFree) {
+                problems.push_back(prefix + "points at a free i-node " + std::to_string(item.iNode));
+                continue;
+            }
+            if (reachable[item.iNode]) {
+                problems.push_back(prefix + "points at an i-node that is already linked " + std::to_string(item.iNode));
+                continue;
+            }
+            if (iNodes[item.iNode].parentId != directory)
+                problems.push_back(prefix + "has an invalid parent id " + std::to_string(iNodes[item.iNode].parentId));
+            if (item.type != getItemType(&iNodes[item.iNode]))
+                problems.push_back(prefix + "has an invalid type " + std::to_string(item.type));
+            reachable[item.iNode] = true;
+            linkedBy[item.iNode] = directory;
+            discovered.push_back(item.iNode);
+            if (iNodes[item.iNode].isDirectory)
+                directories.push(item.iNode);
+        }
+    }
+
+    LOG_INFO("Checking the usage of the directory trees");
+    std::vector<int64_t> subtreeSizes(INODES_COUNT, 0);
+    std::vector<int64_t> subtreeClusters(INODES_COUNT, 0);
+    subtreeClusters[ROOT_INODE_ID] = getNumberOfOccupiedClusters(&iNodes[ROOT_INODE_ID]);
+    for (int32_t iNode : discovered)
+        if (iNodes[iNode].isDirectory)
+            subtreeClusters[iNode] = getNumberOfOccupiedClusters(&iNodes[iNode]);
+
+    // the i-nodes are discovered after their parents, so going
+    // backwards adds up the trees from the bottom
+    for (auto it = discovered.rbegin(); it != discovered.rend(); ++it) {
+        INode_t *iNode = &iNodes[*it];
+        subtreeSizes[linkedBy[*it]] += iNode->isDirectory ? subtreeSizes[*it] : iNode->size;
+        subtreeClusters[linkedBy[*it]] += iNode->isDirectory ? subtreeClusters[*it] : getNumberOfOccupiedClusters(iNode);
+    }
+    for (int32_t i = 0; i < INODES_COUNT; i++) {
+        if (reachable[i] == false || iNodes[i].isDirectory == false)
+            continue;
+        if (iNodes[i].subtreeSize == subtreeSizes[i] && iNodes[i].subtreeClusters == subtreeClusters[i])
+            continue;
+        problems.push_back("directory " + std::to_string(i) + ": invalid usage of the tree (" + std::to_string(iNodes[i].subtreeSize) + "B, " +
+                           std::to_string(iNodes[i].subtreeClusters) + " clusters instead of " + std::to_string(subtreeSizes[i]) + "B, " +
+                           std::to_string(subtreeClusters[i]) + " clusters)");
+        if (repair) {
+            iNodes[i].subtreeSize = subtreeSizes[i];
+            iNodes[i].subtreeClusters = subtreeClusters[i];
+        }
+    }
+
+    LOG_INFO("Looking for orphan i-nodes");
+    for (int32_t i = 0; i < INODES_COUNT; i++) {
+        if (iNodes[i].isFree || reachable[i])
+            continue;
+        problems.push_back("i-node " + std::to_string(i) + ": orphan (not reachable from the root directory)");
+        if (repair) {
+            // the clusters of the i-node will be released
+            // as leaked clusters further down
+            checked[i].clusters.clear();
+            iNodes[i].parentId = NULL_POINTER;
+            iNodes[i].size = 0;
+            iNodes[i].isFree = true;
+            iNodes[i].isDirectory = false;
+            iNodes[i].isSymbolicLink = false;
+            iNodes[i].isInline = false;
+            iNodes[i].packOffset = NULL_POINTER;
+            iNodes[i].subtreeSize = 0;
+            iNodes[i].subtreeClusters = 0;
+            memset(iNodes[i].direct, NULL_POINTER, sizeof(iNodes[i].direct));
+            memset(iNodes[i].indirect, NULL_POINTER, sizeof(iNodes[i].indirect));
+            iNodes[i].directoryIndex = NULL_POINTER;
+        }
+    }
+
+    LOG_INFO("Cross-checking the bitmap against the clusters of the i-nodes");
+    std::vector<int32_t> owners(CLUSTER_COUNT, NULL_POINTER);
+    std::map<int32_t, std::vector<std::pair<int32_t, int32_t>>> packedFiles; // shared cluster -> (offset, i-node)
+    for (int32_t i = 0; i < INODES_COUNT; i++) {
+        for (int32_t cluster : checked[i].clusters) {
+            // small files may share a cluster as long as their content does not overlap
+            bool packed = owners[cluster] != NULL_POINTER && iNodes[owners[cluster]].packOffset != NULL_POINTER && iNodes[i].packOffset != NULL_POINTER;
+            if (packed == false && owners[cluster] != NULL_POINTER && owners[cluster] != i)
+                problems.push_back("cluster " + std::to_string(cluster) + ": shared by i-nodes " +
+                                   std::to_string(owners[cluster]) + " and " + std::to_string(i));
+            if (iNodes[i].packOffset != NULL_POINTER)
+                packedFiles[cluster].push_back({iNodes[i].packOffset, i});
+            owners[cluster] = i;
+            if (isClusterFree(cluster)) {
+                problems.push_back("cluster " + std::to_string(cluster) + ": used by i-node " + std::to_string(i) + " but free in the bitmap");
+                if (repair)
+                    setClusterFree(cluster, false);
+            }
+        }
+    }
+    LOG_INFO("Checking the content of the files sharing a cluster does not overlap");
+    for (auto &cluster : packedFiles) {
+        // every file is compared with the one reaching the furthest among those stored before it
+        std::sort(cluster.second.begin(), cluster.second.end());
+        int32_t furthest = NULL_POINTER;
+        for (auto &file : cluster.second) {
+            int32_t id = file.second;
+            if (furthest != NULL_POINTER && file.first < iNodes[furthest].packOffset + iNodes[furthest].size)
+                problems.push_back("cluster " + std::to_string(cluster.first) + ": overlapping content of i-nodes " +
+                                   std::to_string(furthest) + " and " + std::to_string(id));
+            if (furthest == NULL_POINTER || file.first + iNodes[id].size > iNodes[furthest].packOffset + iNodes[furthest].size)
+                furthest = id;
+        }
+    }
+    int32_t leakedClusters = 0;
+    for (int32_t i = 0; i < CLUSTER_COUNT; i++) {
+        if (isClusterFree(i) == false && owners[i] == NULL_POINTER) {
+            leakedClusters++;
+            if (repair)
+                setClusterFree(i, true);
+        }
+    }
+    if (leakedClusters > 0)
+        problems.push_back(std::to_string(leakedClusters) + " leaked cluster(s) (used in the bitmap but not occupied by any i-node)");
+
+    for (auto &problem : problems)
+        Logger::getOutput() << problem << "\n";
+    if (problems.empty()) {
+        USER_ALERT(Logger::STATUS_OK);
+        return;
+    }
+    USER_ALERT(std::to_string(problems.size()) + " PROBLEM(S) FOUND");
+    if (repair) {
+        LOG_INFO("Storing the changes on the disk");
+        clearDentryCache();
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            for (auto &name : iNodeNames)
+                name.clear();
+        }
+        loadPackedClusters();
+        saveBitmapOnDisk();
+        saveINodesOnDisk();
+        USER_ALERT(Logger::STATUS_REPAIRED);
+    }
+}
+
+bool Disk::isInSubtree(INode_t *iNode, INode_t *directoryINode) {
+    // the number of steps is limited in case
+    // the parent ids happen to form a cycle
+    for (int i = 0; i < INODES_COUNT; i++) {
+        if (iNode->nodeId == directoryINode->nodeId)
+            return true;
+        if (iNode->parentId == iNode->nodeId || iNode->parentId < 0 || iNode->parentId >= INODES_COUNT)
+            return false;
+        iNode = &iNodes[iNode->parentId];
+    }
+    return false;
+}
+
+int32_t Disk::getNumberOfFragments(const std::vector<int32_t> &clusters) const {
+    int32_t fragments = clusters.empty() ? 0 : 1;
+    for (size_t i = 1; i < clusters.size(); i++)
+        if (clusters[i] != clusters[i - 1] + 1)
+            fragments++;
+    return fragments;
+}
+
+int32_t Disk::getFreeRunOfClusters(int32_t n) {
+    int32_t length = 0;
+    for (int32_t i = 0; i < CLUSTER_COUNT; i++) {
+        length = isClusterFree(i) ? length + 1 : 0;
+        if (length == n)
+            return i - n + 1;
+    }
+    return NULL_POINTER;
+}
+
+bool Disk::defragmentFile(INode_t *iNode, std::chrono::steady_clock::time_point deadline) {
+    LOG_INFO("Defragmenting the file");
+    if (defragRunStart == NULL_POINTER) {
+        if (iNode->isFree || iNode->isDirectory)
+            return false;
+
+        std::vector<int32_t> clusters = getAllClustersOfINode(iNode);
+        if (getNumberOfFragments(clusters) <= 1)
+            return false;
+
+        int32_t first = getFreeRunOfClusters(clusters.size());
+        if (first == NULL_POINTER) {
+            LOG_WARNING("There's no contiguous run of free clusters big enough for the file");
+            return false;
+        }
+        LOG_INFO("Reserving the contiguous run of clusters");
+        for (int32_t i = 0; i < (int32_t)clusters.size(); i++)
+            setClusterFree(first + i, false);
+        defragRunStart = first;
+        defragCopied = 0;
+        defragSourceClusters = clusters;
+        defragSourceRemoved = false;
+    }
+    // the lock of the tree has been released since the copying started
+    else if (defragSourceRemoved || iNode->isFree || getAllClustersOfINode(iNode) != defragSourceClusters) {
+        LOG_INFO("The file has changed since it started being copied");
+        cancelRelocation();
+        return false;
+    }
+    const std::vector<int32_t> &clusters = defragSourceClusters;
+    int32_t numberOfClusters = clusters.size();
+
+    LOG_INFO("Copying the content of the file into the run of clusters");
+    const int32_t CLUSTERS_PER_WRITE = 64;
+    auto buff = std::unique_ptr<char[]>(new char[CLUSTERS_PER_WRITE * superBlock->clusterSize]);
+    while (defragCopied < numberOfClusters) {
+        int32_t count = std::min(CLUSTERS_PER_WRITE, numberOfClusters - defragCopied);
+        for (int32_t j = 0; j < count; j++)
+            readFromDisk(&buff[j * superBlock->clusterSize], sizeof(char), superBlock->clusterSize, dataOffset(clusters[defragCopied + j]));
+        writeToDisk(buff.get(), sizeof(char), count * superBlock->clusterSize, dataOffset(defragRunStart + defragCopied));
+        defragCopied += count;
+        if (defragCopied < numberOfClusters && std::chrono::steady_clock::now() >= deadline)
+            return false;
+    }
+    std::vector<int32_t> newClusters;
+    for (int32_t i = 0; i < numberOfClusters; i++)
+        newClusters.push_back(defragRunStart + i);
+
+    // the original pointers are kept until the new ones are attached,
+    // so the file stays as it was if the attaching fails
+    LOG_INFO("Rewriting the pointers of the i-node");
+    std::vector<int32_t> indirectClusters = getIndirectClustersOfINode(iNode);
+    INode_t original = *iNode;
+    memset(iNode->direct, NULL_POINTER, sizeof(iNode->direct));
+    memset(iNode->indirect, NULL_POINTER, sizeof(iNode->indirect));
+    if (attachClustersToINode(iNode, newClusters) == false) {
+        LOG_ERR("Attaching clusters to the i-node failed");
+        memcpy(iNode->direct, original.direct, sizeof(iNode->direct));
+        memcpy(iNode->indirect, original.indirect, sizeof(iNode->indirect));
+        cancelRelocation();
+        return false;
+    }
+
+    LOG_INFO("Releasing the original clusters of the file");
+    releaseClusters(clusters);
+    releaseClusters(indirectClusters);
+    defragRunStart = NULL_POINTER;
+    defragSourceClusters.clear();
+    saveBitmapOnDisk();
+    saveINodesOnDisk();
+    return true;
+}
+
+void Disk::cancelRelocation() {
+    if (defragRunStart == NULL_POINTER)
+        return;
+    LOG_INFO("Releasing the run of clusters the file was being copied into");
+    std::vector<int32_t> run;
+    for (int32_t i = 0; i < (int32_t)defragSourceClusters.size(); i++)
+        run.push_back(defragRunStart + i);
+    releaseClusters(run);
+    defragRunStart = NULL_POINTER;
+    defragSourceClusters.clear();
+}
+
+void Disk::defragment(INode_t *iNode) {
+    LOG_INFO("Starting defragmenting the file system");
+    if (iNode == NULL) {
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
+        return;
+    }
+    ExclusiveLock_t treeGuard(treeLock);
+    returnCachedClusters();
+    cancelRelocation();
+    defragRootId = iNode->nodeId;
+    defragNextINodeId = 0;
+    defragRelocated = 0;
+
+    if (continueDefragmentation(DEFRAG_TIME_BUDGET) == true) {
+        USER_ALERT(Logger::STATUS_DEFRAGMENTING);
+        return;
+    }
+    USER_ALERT(Logger::STATUS_OK);
+}
+
+bool Disk::defragmentStep(int32_t timeBudget) {
+    LOG_INFO("Performing a step of the defragmentation");
+    if (isDefragmenting() == false)
+        return false;
+    ExclusiveLock_t treeGuard(treeLock);
+    returnCachedClusters();
+    return continueDefragmentation(timeBudget);
+}
+
+bool Disk::continueDefragmentation(int32_t timeBudget) {
+    if (isDefragmenting() == false)
+        return false;
+
+    // the directory might have been removed
+    // since the defragmentation started
+    INode_t *rootINode = &iNodes[defragRootId];
+    if (rootINode->isFree) {
+        cancelRelocation();
+        defragRootId = NULL_POINTER;
+        return false;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeBudget);
+    for (; defragNextINodeId < INODES_COUNT; defragNextINodeId++) {
+        if (std::chrono::steady_clock::now() >= deadline)
+            return true;
+        INode_t *iNode = &iNodes[defragNextINodeId];
+        if (defragRunStart == NULL_POINTER && (iNode->isFree || iNode->isDirectory || isInSubtree(iNode, rootINode) == false))
+            continue;
+        if (defragmentFile(iNode, deadline))
+            defragRelocated++;
+
+        // a big file is copied across several steps
+        if (defragRunStart != NULL_POINTER)
+            return true;
+    }
+    LOG_INFO("Defragmentation finished, relocated files: " + std::to_string(defragRelocated));
+    defragRootId = NULL_POINTER;
+    return false;
+}
+
+bool Disk::isDefragmenting() const {
+    return defragRootId != NULL_POINTER;
+}
+
+bool Disk::isMounted() const {
+    return mounted;
+}
+
+void Disk::printStatistics(INode_t *iNode) {
+    LOG_INFO("Printing out statistics of the file system");
+    if (iNode == NULL) {
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
+        return;
+    }
+    int32_t usedINodes = 0;
+    int32_t files = 0;
+    int32_t fragmentedFiles = 0;
+    int32_t fragments = 0;
+    int32_t directories = 0;
+    int32_t directoryClusters = 0;
+    int32_t unusedDirectoryClusters = 0;
+    int32_t indirectClusters = 0;
+    int32_t indexClusters = 0;
+    int64_t fileSlack = 0;
+    int64_t directorySlack = 0;
+    int32_t packedFiles = 0;
+    ExclusiveLock_t treeGuard(treeLock);
+    returnCachedClusters();
+
+    // formated output aligned from left
+    Logger::getOutput() << std::left << std::setw(10) << std::setfill(' ') << "size(B)";
+    Logger::getOutput() << std::left << std::setw(10) << std::setfill(' ') << "clusters";
+    Logger::getOutput() << std::left << std::setw(11) << std::setfill(' ') << "fragments";
+    Logger::getOutput() << std::left << std::setw(10) << std::setfill(' ') << "slack(B)" << "file\n";
+
+    for (int32_t i = 0; i < INODES_COUNT; i++) {
+        if (iNodes[i].isFree)
+            continue;
+        usedINodes++;
+        std::vector<int32_t> clusters = getAllClustersOfINode(&iNodes[i]);
+        bool shared = iNodes[i].isInline || iNodes[i].packOffset != NULL_POINTER;
+        int64_t slack = shared ? 0 : (int64_t)clusters.size() * superBlock->clusterSize - iNodes[i].size;
+        indirectClusters += getIndirectClustersOfINode(&iNodes[i]).size();
+        indexClusters += getIndexClustersOfINode(&iNodes[i]).size();
+
+        if (iNodes[i].isDirectory) {
+            directories++;
+            directoryClusters += clusters.size();
+            unusedDirectoryClusters += clusters.size() - getNumberOfClustersOfINode(&iNodes[i]);
+            directorySlack += slack;
+            continue;
+        }
+        int32_t fileFragments = getNumberOfFragments(clusters);
+        files++;
+        if (iNodes[i].packOffset != NULL_POINTER)
+            packedFiles++;
+        fragments += fileFragments;
+        fileSlack += slack;
+        if (fileFragments > 1)
+            fragmentedFiles++;
+
+        if (isInSubtree(&iNodes[i], iNode)) {
+            std::string path = getPath(&iNodes[i]);
+            path.pop_back();
+            Logger::getOutput() << std::left << std::setw(10) << std::setfill(' ') << iNodes[i].size;
+            Logger::getOutput() << std::left << std::setw(10) << std::setfill(' ') << clusters.size();
+            Logger::getOutput() << std::left << std::setw(11) << std::setfill(' ') << fileFragments;
+            Logger::getOutput() << std::left << std::setw(10) << std::setfill(' ') << slack << path << "\n";
+        }
+    }
+
+    LOG_INFO("Collecting the free extents");
+    std::vector<int32_t> histogram;
+    int32_t freeClusters = 0;
+    int32_t freeExtents = 0;
+    int32_t largestFreeExtent = 0;
+    for (int32_t i = 0; i < CLUSTER_COUNT;) {
+        if (isClusterFree(i) == false) {
+            i++;
+            continue;
+        }
+        int32_t length = 0;
+        for (; i < CLUSTER_COUNT && isClusterFree(i); i++)
+            length++;
+        freeClusters += length;
+        freeExtents++;
+        largestFreeExtent = std::max(largestFreeExtent, length);
+
+        // extents are put into buckets by powers of two (1, 2-3, 4-7, ...)
+        size_t bucket = 0;
+        while ((length >> (bucket + 1)) > 0)
+            bucket++;
+        if (histogram.size() <= bucket)
+            histogram.resize(bucket + 1, 0);
+        histogram[bucket]++;
+    }
+
+    Logger::getOutput() << "<[VOLUME]>\n";
+    Logger::getOutput() << "files:             " << files << " (fragmented: " << fragmentedFiles << ")\n";
+    Logger::getOutput() << "fragments:         " << fragments << "\n";
+    Logger::getOutput() << "file slack:        " << fileSlack << "B\n";
+    Logger::getOutput() << "packed files:      " << packedFiles << " (shared clusters: " << packedClusters.size() << ")\n";
+    Logger::getOutput() << "directories:       " << directories << " (clusters: " << directoryClusters << ", unused: " << unusedDirectoryClusters << ")\n";
+    Logger::getOutput() << "directory slack:   " << directorySlack << "B\n";
+    Logger::getOutput() << "indirect clusters: " << indirectClusters << "\n";
+    Logger::getOutput() << "index clusters:    " << indexClusters << "\n";
+    Logger::getOutput() << "i-nodes:           " << usedINodes << "/" << INODES_COUNT << " used (" << (100 * usedINodes / INODES_COUNT) << "%)\n";
+    Logger::getOutput() << "clusters:          " << (CLUSTER_COUNT - freeClusters) << "/" << CLUSTER_COUNT << " used (" << (100LL * (CLUSTER_COUNT - freeClusters) / CLUSTER_COUNT) << "%)\n";
+    Logger::getOutput() << "free extents:      " << freeExtents << " (largest: " << largestFreeExtent << " clusters)\n";
+    for (size_t i = 0; i < histogram.size(); i++) {
+        if (histogram[i] == 0)
+            continue;
+        int32_t from = 1 << i;
+        int32_t to = (1 << (i + 1)) - 1;
+        std::string range = from == to ? std::to_string(from) : std::to_string(from) + "-" + std::to_string(to);
+        Logger::getOutput() << "  " << std::left << std::setw(17) << std::setfill(' ') << range << histogram[i] << "\n";
+    }
+}
+
+void Disk::find(INode_t *directoryINode, std::string pattern, int64_t minSize, int64_t maxSize) {
+    LOG_INFO("Finding files and folders matching the pattern");
+    if (directoryINode == NULL) {
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
+        return;
+    }
+    if (directoryINode->isDirectory == false) {
+        USER_ALERT(Logger::STATUS_NOT_A_DIRECTORY);
+        return;
+    }
+    // names are stored zero-padded, so a name without any wildcards can be
+    // compared as a whole fixed-size field (a long one the same way it's stored)
+    bool wildcards = pattern.find_first_of("*?[\\") != std::string::npos;
+    char name[FILE_NAME_LEN] = {};
+    strncpy(name, normalizeName(pattern).c_str(), FILE_NAME_LEN);
+    SharedLock_t treeGuard(treeLock);
+    std::unordered_map<int32_t, std::vector<DirectoryItem_t>> tree = readDirectoryTree(directoryINode);
+
+    std::vector<std::string> paths;
+    for (auto &directory : tree) {
+        for (auto &item : directory.second) {
+            INode_t *iNode = &iNodes[item.iNode];
+            if (iNode->isDirectory == false && (iNode->size < minSize || iNode->size > maxSize))
+                continue;
+            if (iNode->isDirectory && (minSize > 0 || maxSize < INT64_MAX))
+                continue;
+            std::string itemName(item.itemName, strnlen(item.itemName, FILE_NAME_LEN));
+            if (wildcards ? fnmatch(pattern.c_str(), itemName.c_str(), 0) != 0 : memcmp(item.itemName, name, FILE_NAME_LEN) != 0)
+                continue;
+            paths.push_back(getPath(&iNodes[directory.first]) + itemName);
+        }
+    }
+    if (paths.empty()) {
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
+        return;
+    }
+    std::sort(paths.begin(), paths.end());
+    for (auto &path : paths)
+        Logger::getOutput() << path << "\n";
+}
+
+void Disk::printDiskUsage(INode_t *iNode) {
+    LOG_INFO("Printing out the usage of the directory tree");
+    if (iNode == NULL) {
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
+        return;
+    }
+    SharedLock_t treeGuard(treeLock);
+    std::string path = getPath(iNode);
+    if (iNode->isDirectory == false)
+        path.pop_back();
+
+    int64_t size;
+    int64_t clusters;
+    {
+        std::lock_guard<std::mutex> lock(metadataMutex);
+        size = iNode->isDirectory ? iNode->subtreeSize : iNode->size;
+        clusters = iNode->isDirectory ? iNode->subtreeClusters : getNumberOfOccupiedClusters(iNode);
+    }
+    Logger::getOutput() << std::left << std::setw(12) << std::setfill(' ') << "size(B)";
+    Logger::getOutput() << std::left << std::setw(10) << std::setfill(' ') << "clusters" << "path\n";
+    Logger::getOutput() << std::left << std::setw(12) << std::setfill(' ') << size;
+    Logger::getOutput() << std::left << std::setw(10) << std::setfill(' ') << clusters;
+    Logger::getOutput() << path << "\n";
+}
+
+int32_t Disk::lookupInDirectory(INode_t *directoryINode, std::string name) {
+    // a long name is looked up the same way it's stored
+    name = normalizeName(name.c_str());
+    name.resize(strnlen(name.c_str(), FILE_NAME_LEN));
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto directory = dentryCache.find(directoryINode->nodeId);
+        if (directory != dentryCache.end()) {
+            auto item = directory->second.find(name);
+            if (item != directory->second.end()) {
+                dentryLRU.splice(dentryLRU.begin(), dentryLRU, item->second.lru);
+                return item->second.iNodeId;
+            }
+        }
+    }
+    int32_t iNodeId = findInDirectory(directoryINode, name);
+    cacheDentry(directoryINode->nodeId, name, iNodeId);
+    return iNodeId;
+}
+
+void Disk::cacheDentry(int32_t directoryId, std::string name, int32_t iNodeId) {
+    name = normalizeName(name.c_str());
+    name.resize(strnlen(name.c_str(), FILE_NAME_LEN));
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto directory = dentryCache.find(directoryId);
+    if (directory != dentryCache.end()) {
+        auto item = directory->second.find(name);
+        if (item != directory->second.end()) {
+            item->second.iNodeId = iNodeId;
+            dentryLRU.splice(dentryLRU.begin(), dentryLRU, item->second.lru);
+            return;
+        }
+    }
+    if (dentryLRU.size() >= DENTRY_CACHE_SIZE) {
+        auto &evicted = dentryLRU.back();
+        auto evictedDirectory = dentryCache.find(evicted.first);
+        evictedDirectory->second.erase(evicted.second);
+        if (evictedDirectory->second.empty())
+            dentryCache.erase(evictedDirectory);
+        dentryLRU.pop_back();
+    }
+    dentryLRU.emplace_front(directoryId, name);
+    dentryCache[directoryId][name] = {iNodeId, dentryLRU.begin()};
+}
+
+void Disk::invalidateDentries(int32_t directoryId) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto directory = dentryCache.find(directoryId);
+    if (directory == dentryCache.end())
+        return;
+    for (auto &item : directory->second)
+        dentryLRU.erase(item.second.lru);
+    dentryCache.erase(directory);
+}
+
+void Disk::clearDentryCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    dentryCache.clear();
+    dentryLRU.clear();
+}
+
+int32_t Disk::getNumberOfItemsInCluster() const {
+    return (superBlock->clusterSize - sizeof(size_t)) / sizeof(DirectoryItem_t);
+}
+
+off_t Disk::getDirectoryItemOffset(INode_t *directoryINode, int32_t position) {
+    int32_t cluster = position / getNumberOfItemsInCluster();
+    int32_t index = position % getNumberOfItemsInCluster();
+    return dataOffset(getClusterOfINode(directoryINode, cluster)) + (cluster == 0 ? sizeof(size_t) : 0) + index * sizeof(DirectoryItem_t);
+}
+
+uint32_t Disk::hashName(const char *name) const {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < FILE_NAME_LEN && name[i] != '\0'; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+int32_t Disk::findInDirectory(INode_t *directoryINode, std::string name, int32_t *position) {
+    LOG_INFO("Finding an item in the directory");
+    DirectoryItem_t item;
+    int32_t count = (directoryINode->size - sizeof(size_t)) / sizeof(DirectoryItem_t);
+
+    if (directoryINode->directoryIndex != NULL_POINTER) {
+        LOG_INFO("Looking the item up in the index of the directory");
+        uint32_t hash = hashName(name.c_str());
+        int32_t cluster = getDirectoryIndexBucket(directoryINode, hash);
+        bool corrupted = cluster == NULL_POINTER;
+
+        int32_t numberOfItemsInBucket = (superBlock->clusterSize - 2 * sizeof(int32_t)) / sizeof(DirectoryIndexItem_t);
+        auto bucket = std::unique_ptr<DirectoryIndexItem_t[]>(new DirectoryIndexItem_t[numberOfItemsInBucket]);
+        int32_t header[2]; // number of items & next cluster of the bucket
+
+        // the number of steps is limited in case
+        // the clusters of the bucket happen to form a cycle
+        for (int32_t steps = 0; corrupted == false && cluster != NULL_POINTER; steps++) {
+            if (steps == CLUSTER_COUNT || readDirectoryIndexHeader(cluster, header) == false) {
+                corrupted = true;
+                break;
+            }
+            readFromDisk(bucket.get(), sizeof(DirectoryIndexItem_t), header[0], dataOffset(cluster) + sizeof(header));
+            for (int32_t i = 0; i < header[0]; i++) {
+                if (bucket[i].hash != hash || bucket[i].position < 0 || bucket[i].position >= count)
+                    continue;
+                readFromDisk(&item, sizeof(DirectoryItem_t), 1, getDirectoryItemOffset(directoryINode, bucket[i].position));
+                if (strncmp(item.itemName, name.c_str(), FILE_NAME_LEN) == 0) {
+                    if (position != NULL)
+                        *position = bucket[i].position;
+                    return item.iNode;
+                }
+            }
+            cluster = header[1];
+        }
+        if (corrupted == false)
+            return NULL_POINTER;
+
+        // the index is rebuilt once the directory is changed
+        // (#updateDirectoryIndex), until then it's searched as a whole
+        LOG_ERR("The index of the directory is corrupted");
+    }
+
+    LOG_INFO("Going through the directory cluster by cluster");
+    DirectoryIterator it = readDirectory(directoryINode);
+    while (it.next(&item))
+        if (strncmp(item.itemName, name.c_str(), FILE_NAME_LEN) == 0) {
+            if (position != NULL)
+                *position = it.getPosition();
+            return item.iNode;
+        }
+    return NULL_POINTER;
+}
+
+bool Disk::saveDirectoryIndexBucket(const INode_t *directoryINode, int32_t cluster, const std::vector<DirectoryIndexItem_t> &items) {
+    int32_t numberOfItemsInBucket = (superBlock->clusterSize - 2 * sizeof(int32_t)) / sizeof(DirectoryIndexItem_t);
+    size_t index = 0;
+    do {
+        int32_t header[2];
+        header[0] = std::min((size_t)numberOfItemsInBucket, items.size() - index);
+        header[1] = NULL_POINTER;
+        if (index + header[0] < items.size()) {
+            header[1] = getFreeCluster(directoryINode);
+            if (header[1] == NULL_POINTER) {
+                LOG_ERR("There's not enough free clusters in the file system");
+                return false;
+            }
+        }
+        writeToDisk(header, sizeof(int32_t), 2, dataOffset(cluster));
+        writeToDisk(items.data() + index, sizeof(DirectoryIndexItem_t), header[0], dataOffset(cluster) + sizeof(header));
+        index += header[0];
+        cluster = header[1];
+    } while (cluster != NULL_POINTER);
+    return true;
+}
+
+void Disk::buildDirectoryIndex(INode_t *directoryINode) {
+    LOG_INFO("Building the index of the directory");
+    removeDirectoryIndex(directoryINode);
+    int32_t count = (directoryINode->size - sizeof(size_t)) / sizeof(DirectoryItem_t);
+    int32_t numberOfItemsInBucket = (superBlock->clusterSize - 2 * sizeof(int32_t)) / sizeof(DirectoryIndexItem_t);
+    int32_t maxNumberOfBuckets = superBlock->clusterSize / sizeof(int32_t) - 1;
+    int32_t numberOfBuckets = (2 * count) / numberOfItemsInBucket + 1;
+    numberOfBuckets = std::min(numberOfBuckets, maxNumberOfBuckets);
+
+    std::vector<int32_t> clusters = getFreeClusters(numberOfBuckets + 1, directoryINode);
+    if ((int32_t)clusters.size() != numberOfBuckets + 1) {
+        LOG_ERR("There's not enough free clusters in the file system");
+        return;
+    }
+    LOG_INFO("Putting the items into the buckets");
+    std::vector<std::vector<DirectoryIndexItem_t>> buckets(numberOfBuckets);
+    DirectoryItem_t item;
+    DirectoryIterator it = readDirectory(directoryINode);
+    while (it.next(&item)) {
+        uint32_t hash = hashName(item.itemName);
+        buckets[hash % numberOfBuckets].push_back({hash, it.getPosition()});
+    }
+    std::vector<int32_t> root;
+    root.push_back(numberOfBuckets);
+    directoryINode->directoryIndex = clusters[0];
+    root.insert(root.end(), clusters.begin() + 1, clusters.end());
+
+    LOG_INFO("Storing the index on the disk");
+    writeToDisk(root.data(), sizeof(int32_t), root.size(), dataOffset(directoryINode->directoryIndex));
+    for (int32_t i = 0; i < numberOfBuckets; i++) {
+        if (saveDirectoryIndexBucket(directoryINode, root[i + 1], buckets[i]) == false) {
+            // the directory will be searched without the index
+            removeDirectoryIndex(directoryINode);
+            break;
+        }
+    }
+    saveBitmapOnDisk();
+}
+
+void Disk::addToDirectoryIndex(INode_t *directoryINode, const char *name, int32_t position) {
+    LOG_INFO("Adding an item into the index of the directory");
+    int32_t count = (directoryINode->size - sizeof(size_t)) / sizeof(DirectoryItem_t);
+    if (directoryINode->directoryIndex == NULL_POINTER) {
+        if (count >= DIR_INDEX_MIN_ITEMS)
+            buildDirectoryIndex(directoryINode);
+        return;
+    }
+    int32_t numberOfItemsInBucket = (superBlock->clusterSize - 2 * sizeof(int32_t)) / sizeof(DirectoryIndexItem_t);
+    int32_t maxNumberOfBuckets = superBlock->clusterSize / sizeof(int32_t) - 1;
+    int32_t numberOfBuckets;
+    DirectoryIndexItem_t item = {hashName(name), position};
+    int32_t cluster = getDirectoryIndexBucket(directoryINode, item.hash, &numberOfBuckets);
+
+    // rebuild the index with more buckets if
+    // they are more than three quarters full
+    if (cluster == NULL_POINTER || (numberOfBuckets < maxNumberOfBuckets && 4 * count > 3 * numberOfBuckets * numberOfItemsInBucket)) {
+        buildDirectoryIndex(directoryINode);
+        return;
+    }
+    int32_t header[2]; // number of items & next cluster of the bucket
+
+    LOG_INFO("Finding a cluster of the bucket with a free slot");
+    for (int32_t steps = 0; ; steps++) {
+        if (steps == CLUSTER_COUNT || readDirectoryIndexHeader(cluster, header) == false) {
+            LOG_ERR("The index of the directory is corrupted");
+            buildDirectoryIndex(directoryINode);
+            return;
+        }
+        if (header[0] < numberOfItemsInBucket)
+            break;
+        if (header[1] == NULL_POINTER) {
+            int32_t newCluster = getFreeCluster(directoryINode);
+            if (newCluster == NULL_POINTER) {
+                LOG_ERR("There's not enough free clusters in the file system");
+                removeDirectoryIndex(directoryINode);
+                return;
+            }
+            writeToDisk(&newCluster, sizeof(int32_t), 1, dataOffset(cluster) + sizeof(int32_t));
+            header[0] = 0;
+            header[1] = NULL_POINTER;
+            cluster = newCluster;
+            saveBitmapOnDisk();
+            break;
+        }
+        cluster = header[1];
+    }
+    writeToDisk(&item, sizeof(DirectoryIndexItem_t), 1, dataOffset(cluster) + sizeof(header) + header[0] * sizeof(DirectoryIndexItem_t));
+    header[0]++;
+    writeToDisk(header, sizeof(int32_t), 2, dataOffset(cluster));
+}
+
+void Disk::updateDirectoryIndex(INode_t *directoryINode, const char *name, int32_t position, int32_t newPosition) {
+    LOG_INFO("Updating an item of the index of the directory");
+    if (directoryINode->directoryIndex == NULL_POINTER)
+        return;
+
+    int32_t header[2]; // number of items & next cluster of the bucket
+    uint32_t hash = hashName(name);
+    int32_t cluster = getDirectoryIndexBucket(directoryINode, hash);
+
+    int32_t numberOfItemsInBucket = (superBlock->clusterSize - 2 * sizeof(int32_t)) / sizeof(DirectoryIndexItem_t);
+    auto bucket = std::unique_ptr<DirectoryIndexItem_t[]>(new DirectoryIndexItem_t[numberOfItemsInBucket]);
+
+    for (int32_t steps = 0; cluster != NULL_POINTER; steps++) {
+        if (steps == CLUSTER_COUNT || readDirectoryIndexHeader(cluster, header) == false)
+            break;
+        readFromDisk(bucket.get(), sizeof(DirectoryIndexItem_t), header[0], dataOffset(cluster) + sizeof(header));
+        for (int32_t i = 0; i < header[0]; i++) {
+            if (bucket[i].hash != hash || bucket[i].position != position)
+                continue;
+            if (newPosition != NULL_POINTER)
+                bucket[i].position = newPosition;
+            else {
+                // the last item of the cluster takes the place of the removed one
+                bucket[i] = bucket[--header[0]];
+                writeToDisk(header, sizeof(int32_t), 1, dataOffset(cluster));
+            }
+            writeToDisk(&bucket[i], sizeof(DirectoryIndexItem_t), 1, dataOffset(cluster) + sizeof(header) + i * sizeof(DirectoryIndexItem_t));
+            return;
+        }
+        cluster = header[1];
+        if (cluster == NULL_POINTER) {
+            LOG_WARNING("The item was not found in the index of the directory");
+            return;
+        }
+    }
+    // the directory is in the middle of being changed, so the index is dropped
+    // and built up again once an item is added into the directory (#addToDirectoryIndex)
+    LOG_ERR("The index of the directory is corrupted");
+    removeDirectoryIndex(directoryINode);
+}
+
+int32_t Disk::getDirectoryIndexBucket(const INode_t *directoryINode, uint32_t hash, int32_t *numberOfBuckets) {
+    int32_t maxNumberOfBuckets = superBlock->clusterSize / sizeof(int32_t) - 1;
+    int32_t buckets;
+    int32_t cluster;
+    if (isValidCluster(directoryINode->directoryIndex) == false)
+        return NULL_POINTER;
+    readFromDisk(&buckets, sizeof(int32_t), 1, dataOffset(directoryINode->directoryIndex));
+    if (buckets <= 0 || buckets > maxNumberOfBuckets)
+        return NULL_POINTER;
+    readFromDisk(&cluster, sizeof(int32_t), 1, dataOffset(directoryINode->directoryIndex) + (1 + hash % buckets) * sizeof(int32_t));
+    if (isValidCluster(cluster) == false)
+        return NULL_POINTER;
+    if (numberOfBuckets != NULL)
+        *numberOfBuckets = buckets;
+    return cluster;
+}
+
+bool Disk::readDirectoryIndexHeader(int32_t cluster, int32_t *header) {
+    int32_t numberOfItemsInBucket = (superBlock->clusterSize - 2 * sizeof(int32_t)) / sizeof(DirectoryIndexItem_t);
+    readFromDisk(header, sizeof(int32_t), 2, dataOffset(cluster));
+    return header[0] >= 0 && header[0] <= numberOfItemsInBucket && (header[1] == NULL_POINTER || isValidCluster(header[1]));
+}
+
+std::vector<int32_t> Disk::getIndexClustersOfINode(INode_t *iNode) {
+    LOG_INFO("Getting the clusters of the index of the directory");
+    std::vector<int32_t> clusters;
+    if (iNode == NULL || iNode->directoryIndex == NULL_POINTER)
+        return clusters;
+
+    int32_t maxNumberOfBuckets = superBlock->clusterSize / sizeof(int32_t) - 1;
+    int32_t numberOfBuckets;
+    clusters.push_back(iNode->directoryIndex);
+    readFromDisk(&numberOfBuckets, sizeof(int32_t), 1, dataOffset(iNode->directoryIndex));
+    if (numberOfBuckets <= 0 || numberOfBuckets > maxNumberOfBuckets) {
+        LOG_ERR("Invalid number of buckets of the index");
+        return clusters;
+    }
+    std::vector<int32_t> buckets(numberOfBuckets);
+    readFromDisk(buckets.data(), sizeof(int32_t), numberOfBuckets, dataOffset(iNode->directoryIndex) + sizeof(int32_t));
+    for (int32_t cluster : buckets) {
+        // follow the chain of (overflow) clusters of the bucket
+        for (int i = 0; cluster != NULL_POINTER && i < CLUSTER_COUNT; i++) {
+            clusters.push_back(cluster);
+            if (isValidCluster(cluster) == false)
+                break;
+            readFromDisk(&cluster, sizeof(int32_t), 1, dataOffset(cluster) + sizeof(int32_t));
+        }
+    }
+    return clusters;
+}
+
+void Disk::removeDirectoryIndex(INode_t *directoryINode) {
+    LOG_INFO("Removing the index of the directory");
+    std::vector<int32_t> clusters = getIndexClustersOfINode(directoryINode);
+
+    // a corrupted index might point outside of the file system
+    clusters.erase(std::remove_if(clusters.begin(), clusters.end(), [this](int32_t cluster) {
+        return isValidCluster(cluster) == false;
+    }), clusters.end());
+    releaseClusters(clusters);
+    directoryINode->directoryIndex = NULL_POINTER;
+    saveBitmapOnDisk();
 }
\ No newline at end of file
@@ -8,10 +8,26 @@
 #include <cstring>
 #include <iomanip>
 #include <stack>
+#include <queue>
+#include <list>
+#include <chrono>
+#include <unordered_map>
+#include <map>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <shared_mutex>
+#include <thread>
 #include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <fnmatch.h>
 
 #include "Setup.h"
 #include "Logger.h"
+#include "ThreadPool.h"
 
 #define UNUSED(x) (void)(x)
 
@@ -21,6 +37,12 @@
 /// file system and provides functionality associated with
 /// it. This class is at the very bottom of the hierarchy
 /// of the project.
+///
+/// The disk can be used by multiple threads (sessions) at the same time.
+/// Every operation holds the lock of the directory tree shared, and the i-nodes it works
+/// with shared (reading) or exclusively (changing them). The operations changing many
+/// i-nodes at once (e.g. removing a whole directory tree) hold the lock of the tree exclusively.
+/// Each thread has its own current (working) directory.
 class Disk {
 public:
     /// a GB unit (1e9 bytes) used when formatting the disk
@@ -52,32 +74,48 @@ public:
 
     /// I-node structure holding all the information
     /// about a folder/file in the file system.
-    /// The overall size of an i-node is 44B.
+    /// The overall size of an i-node is 128B.
     struct INode_t {
         int32_t nodeId;       ///< i-node id (0,1,...,n)
         int32_t parentId;     ///< id of the parent of the i-node
         bool isFree;          ///< flag if the i-node is free
         bool isDirectory;     ///< flag if the i-node is a directory
         bool isSymbolicLink;  ///< flag if the i-node is a symbolic link
+        bool isInline;        ///< flag if the content is stored in #inlineData rather than in clusters
         int32_t size;         ///< total size of the i-node
         int32_t direct[NUM_OF_DIRECT_POINTERS];     ///< direct pointers to the clusters making up the file/folder
         int32_t indirect[NUM_OF_INDIRECT_POINTERS]; ///< indirect pointers to the clusters making up the file/folder
+        int32_t directoryIndex; ///< root cluster of the hashed index of the directory (#NULL_POINTER if the directory is not indexed)
+        char inlineData[INLINE_DATA_LEN]; ///< content of a small i-node (only if #isInline is set)
+        int32_t packOffset;   ///< offset of the content within a cluster shared by small files - direct[0] (#NULL_POINTER if the i-node is not packed)
+        int64_t subtreeSize;     ///< total size of the files within the directory tree (only directories)
+        int64_t subtreeClusters; ///< number of clusters taken up by the directory tree including the directory itself (only directories)
+    };
+
+    /// Types of the items of a directory
+    enum ItemType : uint8_t {
+        ITEM_FILE = 0,      ///< regular file
+        ITEM_DIRECTORY,     ///< directory
+        ITEM_SYMBOLIC_LINK  ///< symbolic link
     };
 
     /// DirectoryItem structure holding information
     /// about an item in a folder, which can be either
-    /// another folder or a file. The overall size
-    /// of a DirectoryItem is 16B.
+    /// another folder or a file. The type of the item is kept
+    /// along with the name, so the content of a directory can be
+    /// told apart without looking at the i-nodes. The overall size
+    /// of a DirectoryItem is 20B.
     struct DirectoryItem_t {
         int32_t iNode;                ///< i-node id (0,1,...,n)
         char itemName[FILE_NAME_LEN]; ///< name of the item
+        uint8_t type;                 ///< type of the item (#ItemType)
     };
 
     /// DirectoryItems structure holding all
     /// items within the directory (filer, other folders)
     /// The whole size of the structure is
     /// sizeof(size_t) + count * sizeof(DirectoryItem_t) =
-    /// (8 + count * 16)B
+    /// (8 + count * 20)B
     struct DirectoryItems_t {
         size_t count;                   ///< number of items in the folder
         DirectoryItem_t *items = NULL;  ///< directory items themselves
@@ -101,14 +139,274 @@ public:
         ~DirectoryItems_t();
     };
 
+    /// Iterator going through the items of a directory
+    ///
+    /// The items are read from the disk cluster by cluster, so only
+    /// one cluster of the directory is held in the memory at a time
+    /// no matter how big the directory is. It is meant to be used
+    /// whenever the directory is being read (listed, searched, etc.)
+    /// rather than loading all the items at once.
+    ///
+    /// The directory must not be modified while it's being iterated.
+    class DirectoryIterator {
+    private:
+        Disk *disk;                         ///< disk the directory is stored on
+        INode_t *directoryINode;            ///< i-node of the directory
+        int32_t count;                      ///< number of items of the directory
+        int32_t position = 0;               ///< position of the next item within the directory
+        std::vector<DirectoryItem_t> items; ///< items of the cluster being iterated
+        size_t index = 0;                   ///< index of the next item within the cluster
+
+    public:
+        /// Constructor - creates an instance of the class
+        ///
+        /// \param disk disk the directory is stored on
+        /// \param directoryINode i-node of the directory
+        DirectoryIterator(Disk *disk, INode_t *directoryINode);
+
+        /// Moves onto the next item of the directory
+        ///
+        /// If all items of the current cluster have been gone through,
+        /// the following cluster of the directory will be read.
+        ///
+        /// \param item the next item will be stored into it
+        /// \return false, if there are no more items in the directory. Otherwise, true.
+        bool next(DirectoryItem_t *item);
+
+        /// Returns the position of the item returned by the last call of #next
+        /// \return position of the item within the directory
+        int32_t getPosition() const;
+    };
+
+    /// Reader going through the content of a file sequentially with a read-ahead
+    ///
+    /// The content is read window by window by a single prefetching thread, which keeps
+    /// up to #READ_AHEAD_WINDOWS windows ready ahead of the caller. The clusters following
+    /// each other are read at once. Since the file is read sequentially, every window is
+    /// twice as big as the previous one (up to #READ_AHEAD_MAX_LEN clusters), so the disk
+    /// is read by bigger requests the further the reader gets. The pointer clusters of the
+    /// file (indirect, middle) are read only once the reader gets to them, and the next
+    /// one is prefetched into the page cache ahead of time. A file fitting into the first
+    /// window is read right away, without the prefetching thread.
+    ///
+    /// The file must not be modified while it's being read.
+    class FileReader {
+    private:
+        Disk *disk;                        ///< disk the file is stored on
+        INode_t *iNode;                    ///< i-node of the file
+        int32_t numberOfClusters;          ///< number of data clusters of the file
+        int32_t nextIndex = 0;             ///< index of the first cluster of the next window that has not been read yet
+        int32_t window = READ_AHEAD_MIN_LEN; ///< size of the next window (clusters)
+        std::vector<int32_t> middlePointers; ///< pointers of the second indirect cluster (read once they are needed)
+        std::vector<int32_t> pointers;     ///< pointers of the pointer cluster the reader is in
+        int32_t pointersCluster;           ///< pointer cluster #pointers have been read from
+
+        std::deque<std::string> windows;      ///< windows read ahead of the caller
+        bool finished = false;                ///< flag if all the windows have been read
+        bool closing = false;                 ///< flag if the reader is being destroyed
+        std::mutex mtx;                       ///< guards the windows and the flags
+        std::condition_variable windowRead;   ///< notifies the caller that a window has been read
+        std::condition_variable windowTaken;  ///< notifies the prefetching thread that a window has been taken
+        std::thread prefetcher;               ///< thread reading the windows ahead of the caller
+
+    public:
+        /// Constructor - creates an instance of the class
+        ///
+        /// The file starts being read right away.
+        ///
+        /// \param disk disk the file is stored on
+        /// \param iNode i-node of the file (stored in clusters of its own)
+        FileReader(Disk *disk, INode_t *iNode);
+
+        /// Destructor - stops the prefetching thread
+        ~FileReader();
+
+        /// Copy constructor - deleted since the windows are being read in the background
+        FileReader(const FileReader &) = delete;
+
+        /// Assignment operator - deleted since the windows are being read in the background
+        void operator=(FileReader const &) = delete;
+
+        /// Moves onto the next window of the file
+        ///
+        /// If the window has not been read yet, it's waited for.
+        ///
+        /// \param data the content of the window will be stored into it
+        /// \return false, if the whole file has been read. Otherwise, true.
+        bool next(std::string &data);
+
+    private:
+        /// The main loop of the prefetching thread - reads the windows one by one
+        /// whenever there are fewer than #READ_AHEAD_WINDOWS of them ready
+        void prefetch();
+
+        /// Reads the content of the clusters of the file given as a parameter
+        ///
+        /// \param first index of the first cluster within the file
+        /// \param count number of clusters
+        /// \return the content of the clusters (the last one of the file is cut off at the size of the file)
+        std::string readWindow(int32_t first, int32_t count);
+
+        /// Returns the cluster of the file given by its index within the file
+        ///
+        /// The pointer clusters are read whole and kept until the reader
+        /// moves past them. Once a pointer cluster is read, the following
+        /// one is prefetched into the page cache.
+        ///
+        /// \param index index of the cluster within the file
+        /// \return the cluster
+        int32_t getCluster(int32_t index);
+
+        /// Reads a pointer cluster of the file as a whole
+        ///
+        /// \param cluster the pointer cluster
+        /// \param pointers the pointers will be stored into it
+        void readPointers(int32_t cluster, std::vector<int32_t> &pointers);
+    };
+
+private:
+    typedef std::shared_lock<std::shared_timed_mutex> SharedLock_t;    ///< a lock held shared (reading)
+    typedef std::unique_lock<std::shared_timed_mutex> ExclusiveLock_t; ///< a lock held exclusively (writing)
+
+    /// Information about an i-node collected when checking
+    /// the consistency of the file system (#checkFileSystem).
+    struct CheckedINode_t {
+        std::vector<int32_t> clusters;      ///< all clusters occupied by the i-node (data + indirect clusters)
+        std::vector<DirectoryItem_t> items; ///< items of the directory (only if the i-node is a directory)
+        std::vector<std::string> problems;  ///< problems found within the i-node
+    };
+
+    /// An item of the hashed index of a directory. The index consists
+    /// of a root cluster holding the number of buckets followed by the clusters
+    /// of the buckets. A bucket cluster holds the number of items in it, the next
+    /// (overflow) cluster of the bucket, and the items themselves. The overall size
+    /// of an index item is 8B.
+    struct DirectoryIndexItem_t {
+        uint32_t hash;    ///< hash of the name of the directory item
+        int32_t position; ///< position of the directory item within the directory
+    };
+
+    /// An item of a directory tree imported from the HDD (#incpyDirectory)
+    struct ImportedItem_t {
+        std::string path;        ///< path to the item on the HDD
+        std::string name;        ///< name of the item within the file system
+        int32_t parent;          ///< index of the parent directory within the imported items (#NULL_POINTER for the imported directory itself)
+        bool isDirectory;        ///< flag if the item is a directory
+        int64_t size;            ///< size of the file (B)
+        INode_t *iNode;          ///< i-node the item is imported into (NULL if the item has not been imported)
+    };
+
+    /// A copy of a file waiting for its content to be copied before it is added into its directory (#copyTree)
+    struct CopiedFile_t {
+        INode_t *iNode;          ///< i-node of the copy
+        INode_t *directoryINode; ///< directory the copy goes into
+        std::string name;        ///< name of the copy
+    };
+
+    /// A name cached in the dentry cache (#lookupInDirectory)
+    struct Dentry_t {
+        int32_t iNodeId; ///< i-node of the item (#NULL_POINTER if there's no such an item in the directory)
+        std::list<std::pair<int32_t, std::string>>::iterator lru; ///< position of the name in the list of the least recently used names
+    };
+
+    /// Clusters reserved by a thread ahead of time, so the threads allocating
+    /// clusters in parallel do not contend on the bitmap (#getFreeClusters)
+    struct AllocationCache_t {
+        std::mutex mtx;                     ///< guards the clusters (it's contended only when the caches are returned #returnCachedClusters)
+        std::vector<std::vector<int32_t>> clusters; ///< reserved clusters that have not been used yet (one list per allocation group)
+        std::atomic<bool> abandoned{false}; ///< flag if the thread the cache belongs to has finished
+    };
+
+    /// An allocation group - a segment of the bitmap and a range of i-nodes
+    ///
+    /// The files are placed into the group of their parent directory, so the files
+    /// of a directory stay close to each other on the disk, and the threads writing
+    /// into different directories do not contend with each other.
+    struct AllocationGroup_t {
+        int32_t firstWord = 0;                  ///< first word of the bitmap segment of the group
+        int32_t lastWord = 0;                   ///< word following the bitmap segment of the group
+        int32_t firstINode = 0;                 ///< first i-node of the group
+        int32_t lastINode = 0;                  ///< i-node following the i-nodes of the group
+        std::atomic<int32_t> freeClusters{0};   ///< number of free clusters of the group (the reserved ones do not count)
+        std::atomic<int32_t> nextFreeWord{0};   ///< word the search for free clusters starts from (relative to #firstWord)
+        std::mutex mtx;                         ///< guards claiming and releasing the i-nodes of the group
+    };
+
+    /// The cache of clusters of the current thread
+    ///
+    /// Once the thread finishes, the cache is marked as abandoned,
+    /// so its clusters can be returned into the bitmap.
+    struct AllocationCacheHandle_t {
+        uint64_t diskId = 0;                      ///< id of the disk the cache belongs to (#diskId)
+        std::shared_ptr<AllocationCache_t> cache; ///< the cache itself
+
+        /// Destructor - marks the cache as abandoned
+        ~AllocationCacheHandle_t();
+    };
+
+    /// A file of a directory tree exported onto the HDD (#outcpyDirectory)
+    struct ExportedFile_t {
+        int32_t iNodeId;  ///< i-node of the file
+        int32_t parentId; ///< i-node of the directory the file has been found in
+        std::string path; ///< path to the file on the HDD
+    };
+
 private:
     int CLUSTER_COUNT;               ///< the total number of clusters in the file system
     FILE *diskFile = NULL;           ///< reference to the storage of the file system
     SuperBlock_t *superBlock = NULL; ///< reference to the superblock of the class
-    bool *bitmap = NULL;             ///< the bitmap of the file system
+    /// the bitmap of the file system held as words of 64 clusters (a set bit means a free cluster),
+    /// the clusters are claimed by atomic compare-and-swap on the words
+    std::unique_ptr<std::atomic<uint64_t>[]> bitmap;
+    int32_t bitmapWords = 0;                 ///< number of words of the bitmap
+    std::unique_ptr<AllocationGroup_t[]> allocationGroups; ///< allocation groups the clusters and the i-nodes are split into
+    int32_t allocationGroupCount = 0;        ///< number of allocation groups
     std::string diskFileName;        ///< the name of the storage (file) of the file system
+    bool mounted = false;            ///< flag if the storage holds a file system that can be used (see #isMounted)
     INode_t iNodes[INODES_COUNT];    ///< the i-nodes of the file system
-    INode_t *currentINode = NULL;    ///< reference to the current i-node (current location)
+    std::atomic<int32_t> defragRootId{NULL_POINTER}; ///< id of the i-node being defragmented (#NULL_POINTER if there's no defragmentation going on)
+    int32_t defragNextINodeId = 0;       ///< id of the next i-node the defragmentation will continue with
+    int32_t defragRelocated = 0;         ///< number of files relocated by the current defragmentation
+    int32_t defragRunStart = NULL_POINTER; ///< first cluster of the run the file #defragNextINodeId is being copied into (#NULL_POINTER if there's no file being copied)
+    int32_t defragCopied = 0;            ///< number of clusters of the file copied into the run so far
+    std::vector<int32_t> defragSourceClusters; ///< original clusters of the file being copied
+    std::atomic<bool> defragSourceRemoved{false}; ///< flag if the file being copied has been removed in the meantime
+
+    /// cached results of looking names up in directories (directory i-node -> name -> i-node),
+    /// names that are not in the directory are cached as #NULL_POINTER
+    std::unordered_map<int32_t, std::unordered_map<std::string, Dentry_t>> dentryCache;
+    std::list<std::pair<int32_t, std::string>> dentryLRU; ///< names of the dentry cache (directory i-node, name) from the most recently used one
+    std::string iNodeNames[INODES_COUNT]; ///< cached names of the i-nodes within their parents (empty if not known yet)
+
+    bool batch = false;          ///< flag if the i-nodes and the bitmap are saved only once the batch is committed (#commitBatch)
+    std::atomic<bool> iNodesChanged{false}; ///< flag if the i-nodes have been changed within the current batch
+    std::atomic<bool> bitmapChanged{false}; ///< flag if the bitmap has been changed within the current batch
+
+    /// clusters shared by small files (cluster -> offset within the cluster -> size of the file),
+    /// it is not stored on the disk but built up from the i-nodes when the file system is loaded
+    std::map<int32_t, std::map<int32_t, int32_t>> packedClusters;
+
+    /// lock of the directory tree, it is held shared by all the operations and exclusively
+    /// by the operations changing or walking through many i-nodes at once (rm -r, cp -r, fsck, ...)
+    std::shared_timed_mutex treeLock;
+    std::shared_timed_mutex iNodeLocks[INODES_COUNT]; ///< locks of the i-nodes (shared when reading the i-node, exclusive when changing it)
+    std::mutex allocatorMutex; ///< guards the clusters shared by small files, the caches of clusters, and storing the bitmap on the disk
+    std::mutex metadataMutex;  ///< guards storing the i-nodes on the disk and the usage of the directory trees
+    std::mutex cacheMutex;     ///< guards the dentry cache and the cached names of the i-nodes
+    std::mutex sessionMutex;   ///< guards the current directories of the sessions
+
+    /// current directories of the sessions (thread -> i-node of the directory),
+    /// a thread that has not changed its directory yet is located in the root directory
+    std::unordered_map<std::thread::id, int32_t> workingDirectories;
+
+    std::vector<std::shared_ptr<AllocationCache_t>> allocationCaches; ///< caches of clusters of the threads allocating clusters on this disk
+    uint64_t diskId;                                                  ///< unique id of the disk, so a thread can tell its cache of clusters belongs to it
+
+    /// workers of the operations split into parallel tasks (it's declared last, so it's destroyed first)
+    ThreadPool threadPool;
+
+    static std::atomic<uint64_t> nextDiskId;                   ///< id of the next instance of the class
+    static thread_local AllocationCacheHandle_t allocationCache; ///< cache of clusters of the current thread
 
 public:
     /// Destructor of the class
@@ -186,18 +484,53 @@ public:
     /// \param iNode i-node of the target folder that is going to be deleted
     void removeDirectory(INode_t *iNode);
 
+    /// Removes a directory (i-node) given as a parameter including all its content
+    ///
+    /// The directory tree is walked in parallel first. Then, all the i-nodes
+    /// are released and the i-nodes as well as the bitmap are stored on the disk
+    /// only once at the end. If the i-node is a file, it will be removed
+    /// as if it was removed by #removeFile.
+    ///
+    /// \param iNode i-node of the target folder that is going to be deleted
+    void removeDirectoryRecursively(INode_t *iNode);
+
     /// Changes the current location (path)
     ///
+    /// The location is kept separately for every thread (session).
+    ///
     /// \param path new current location
     void cd(std::string path);
 
+    /// Ends the session of the calling thread
+    ///
+    /// The current location of the thread is forgotten, so the next
+    /// session run by the thread starts in the root directory.
+    void closeSession();
+
+    /// Returns the id of the current directory of the calling thread (session)
+    ///
+    /// \return id of the i-node of the current directory
+    int32_t getWorkingDirectory();
+
+    /// Moves the calling thread (session) to the directory given as a parameter
+    ///
+    /// It is used to take the current location of another thread over, e.g. by
+    /// a thread performing an operation on behalf of the thread. If the directory
+    /// has been removed in the meantime, the session starts in the root directory.
+    ///
+    /// \param directoryId id of the i-node of the directory
+    void setWorkingDirectory(int32_t directoryId);
+
     /// Prints out the content of the current directory.
     void printCurrentDirectoryItems();
 
-    /// Prints out directory items (content of a directory) given as a parameter
+    /// Prints out the content of the directory given as a parameter
     ///
-    /// \param directoryItems directory items that are going to be printed out
-    void printDirectoryItems(const DirectoryItems_t *directoryItems);
+    /// The items are loaded and printed out cluster by cluster,
+    /// so the whole directory is never held in the memory.
+    ///
+    /// \param directoryINode i-node of the directory that is going to be printed out
+    void printDirectoryItems(INode_t *directoryINode);
 
     /// Returns directory items from the i-node given as a parameter
     ///
@@ -208,6 +541,20 @@ public:
     /// \return directory items of the folder (i-node) given as a parameter.
     DirectoryItems_t *getDirectoryItemsFromINode(INode_t *iNode);
 
+    /// Returns an iterator going through the items of the directory given as a parameter
+    ///
+    /// ### Example
+    /// ```
+    /// Disk::DirectoryItem_t item;
+    /// auto it = disk->readDirectory(directoryINode);
+    /// while (it.next(&item))
+    ///     std::cout << item.itemName << "\n";
+    /// ```
+    ///
+    /// \param directoryINode i-node of the directory
+    /// \return iterator of the items of the directory
+    DirectoryIterator readDirectory(INode_t *directoryINode);
+
     /// Returns the current path as a string
     ///
     /// The format of the path is absolute, meaning it goes all the way down
@@ -230,7 +577,8 @@ public:
     ///
     /// \param iNode iNode of the file we want to print out
     /// \param includeSlinks true/false whether we want to print out symbolic links as well.
-    void printFileContent(INode_t *iNode, bool includeSlinks);
+    /// \param stream the stream the content is written into (e.g. #Logger::getOutput)
+    void printFileContent(INode_t *iNode, bool includeSlinks, std::ostream &stream);
 
     /// Imports the file given as a paramter into the virtual file system
     ///
@@ -243,6 +591,20 @@ public:
     /// \param fileName the name of the file in the virtual file system
     void incpyFile(INode_t *destinationINode, FILE *sourceFile, std::string fileName);
 
+    /// Imports the directory given as a parameter (a path on the HDD) including all its content into the virtual file system
+    ///
+    /// The directory tree on the HDD is walked first and the i-nodes of all its items are claimed at once (#getFreeINodes).
+    /// Then, the directories are created and the files are imported by the tasks of a thread pool. Each task reads its
+    /// file, allocates the clusters and attaches them to the i-node of the file. The content of a large file is written
+    /// in runs of at most #COPY_RUN_LEN clusters, each of them by a task of its own. Then, the files are added into
+    /// their directories. The tree is built aside while holding the tree lock shared, and it's added into the destination
+    /// directory only once it's complete (under the exclusive lock of the destination).
+    ///
+    /// \param destinationINode i-node of the folder we are importing the directory into within the file system
+    /// \param sourcePath path to the source directory on the HDD
+    /// \param directoryName the name of the directory in the virtual file system
+    void incpyDirectory(INode_t *destinationINode, std::string sourcePath, std::string directoryName);
+
     /// Exports the file given as a paramter (i-node) from the virtual file system onto the HDD
     ///
     /// First, it collects all the clusters the file content is stored in and then,
@@ -252,6 +614,18 @@ public:
     /// \param destinationFile the file desctiptor of the destination file on the HDD
     void outcpyFile(INode_t *sourceINode, FILE *destinationFile);
 
+    /// Exports the directory given as a parameter (i-node) including all its content onto the HDD
+    ///
+    /// The directory tree is walked in parallel (#readDirectoryTree) and the directories are created on the HDD.
+    /// Then, the files are written by the tasks of a thread pool. The cluster lists of the files are read ahead
+    /// of the writers (at most #EXPORT_READ_AHEAD files), and the content of the clusters is prefetched
+    /// (#prefetchClusters), so it is likely to be cached once the file is written. Symbolic links are
+    /// exported as symbolic links pointing at the same path.
+    ///
+    /// \param directoryINode i-node of the source directory within the file system
+    /// \param destinationPath path to the destination directory on the HDD
+    void outcpyDirectory(INode_t *directoryINode, std::string destinationPath);
+
     /// Copies the file give as a parameter (i-node) to a different directory
     ///
     /// It does not have to be necessary a different directory if the name if the file differs.
@@ -263,9 +637,23 @@ public:
     /// \param fileName name of copied copied file
     void copyFileToADifferentDirectory(INode_t *fileINode, INode_t *destinationINode, std::string fileName);
 
+    /// Copies the directory given as a parameter (i-node) including all its content into a different directory
+    ///
+    /// The directory tree is walked in parallel first. Then, the copies of the directories and files
+    /// are created (all the metadata is stored on the disk only once at the end) and the content
+    /// of the files is copied in parallel runs of clusters.
+    ///
+    /// \param directoryINode i-node of the source directory (that is going to be copied)
+    /// \param destinationINode i-node of the destination directory
+    /// \param directoryName name of the copied directory
+    void copyDirectoryToADifferentDirectory(INode_t *directoryINode, INode_t *destinationINode, std::string directoryName);
+
     /// Moves the file given as a parameter to a different directory.
     ///
     /// This method can be also used for renaming files within the same directory.
+    /// A directory is moved as a whole by relinking its item and updating its '..' item,
+    /// so the cost does not depend on the size of its content. A directory cannot
+    /// be moved into itself or any of its subdirectories.
     ///
     /// \param fileINode i-node of the source file (that is going to be moved)
     /// \param destinationINode i-node of the destination directory the file is being moved into
@@ -291,6 +679,117 @@ public:
     /// \param slinkName name of the symbolic link that is being created
     void createSymbolicLink(INode_t *fileINode, std::string slinkName);
 
+    /// Checks the consistency of the file system (fsck)
+    ///
+    /// First, all the i-nodes are checked in parallel by a pool of threads,
+    /// each of which takes care of a range of i-nodes. It collects all
+    /// the clusters occupied by the i-nodes (direct pointers, both levels of
+    /// indirect pointers as well as the clusters of directories) and the items
+    /// of the directories. Afterwards, the directory tree is walked from the root
+    /// directory and the bitmap is cross-checked against the collected clusters.
+    /// Leaked clusters (used in the bitmap but not occupied by any i-node) and
+    /// orphan i-nodes (not reachable from the root directory) can be repaired.
+    ///
+    /// \param repair true/false whether leaked clusters and orphan i-nodes should be repaired
+    void checkFileSystem(bool repair);
+
+    /// Starts defragmenting all the files within the directory given as a parameter
+    ///
+    /// If the i-node is a file, only the file will be defragmented. The defragmentation
+    /// runs incrementally. The first step is performed right away. If it does not
+    /// manage to go through all the files within the time budget (#DEFRAG_TIME_BUDGET),
+    /// the rest of the work will be done in the following steps (#defragmentStep),
+    /// e.g. while the shell is waiting for the user to enter another command.
+    ///
+    /// \param iNode i-node of the directory (or file) that is going to be defragmented
+    void defragment(INode_t *iNode);
+
+    /// Performs one step of the defragmentation
+    ///
+    /// It relocates fragmented files one by one into contiguous runs
+    /// of clusters until the time budget runs out.
+    ///
+    /// \param timeBudget time budget of the step in milliseconds
+    /// \return true, if there is still some work left. Otherwise (the defragmentation has finished), false.
+    bool defragmentStep(int32_t timeBudget);
+
+    /// Returns true if there's a defragmentation going on
+    /// \return true, if the defragmentation has not finished yet. Otherwise, false.
+    bool isDefragmenting() const;
+
+    /// Returns true if the file system can be used
+    ///
+    /// A storage created by an incompatible version is not mounted and stays
+    /// untouched. The only way to use it is to format it explicitly (#format).
+    ///
+    /// \return false, if the storage holds an incompatible file system. Otherwise, true.
+    bool isMounted() const;
+
+    /// Prints out fragmentation and space-usage statistics
+    ///
+    /// First, it prints out the number of clusters, fragments, and the slack (unused
+    /// space of the last cluster) of every file within the directory given as a parameter.
+    /// Then, it prints out the statistics of the whole volume - the number of fragments,
+    /// internal fragmentation (slack of the files, unused clusters reserved by directories),
+    /// utilization of the i-nodes and clusters, and a histogram of the sizes of the
+    /// free extents (runs of free clusters) including the largest one.
+    ///
+    /// \param iNode i-node of the directory (or file) whose files are going to be printed out
+    void printStatistics(INode_t *iNode);
+
+    /// Prints out the paths of the files and folders within the directory tree whose names match the pattern
+    ///
+    /// The directory tree is walked in parallel (#readDirectoryTree). The pattern can contain
+    /// the wildcards '*', '?' and '[...]'. A pattern without any wildcards is compared
+    /// against the whole (zero-padded) name field of the directory items at once.
+    ///
+    /// \param directoryINode i-node of the directory the search starts in
+    /// \param pattern pattern of the names
+    /// \param minSize minimum size of the matching files (B)
+    /// \param maxSize maximum size of the matching files (B)
+    void find(INode_t *directoryINode, std::string pattern, int64_t minSize, int64_t maxSize);
+
+    /// Prints out the total size and the number of clusters of the directory tree (or a file)
+    ///
+    /// The numbers are kept up to date in the directory i-nodes, so the directory tree
+    /// does not need to be walked. The clusters include the indirect clusters, but not
+    /// the clusters shared by small files and the clusters of the indexes of the directories.
+    ///
+    /// \param iNode i-node of the directory (or file)
+    void printDiskUsage(INode_t *iNode);
+
+    /// Returns a free an index of a free cluster
+    ///
+    /// This method is widely used when importing a new file into
+    /// the virtual file system, as well as when copying a file into
+    /// a different directory.
+    ///
+    /// \param iNode i-node the cluster is going to belong to, the cluster is taken
+    /// from its allocation group (NULL if it does not matter)
+    /// \return an index of a free cluster. If there are no free clusters
+    /// in the file system, it will return #NULL_POINTER
+    int32_t getFreeCluster(const INode_t *iNode = NULL);
+
+    /// Returns n free clusters
+    ///
+    /// The clusters are allocated all at once, so either all
+    /// of them are allocated or none of them. A few clusters
+    /// (up to #ALLOCATION_CACHE_LEN) are taken from the cache of the
+    /// calling thread, which is refilled from the bitmap in bulk.
+    /// More clusters are claimed from the bitmap directly. The clusters are
+    /// taken from the allocation group of the i-node (#getAllocationGroupOfClusters),
+    /// if there are enough of them. Otherwise, the following groups are used as well.
+    ///
+    /// \param n number of clusters
+    /// \param iNode i-node the clusters are going to belong to (NULL if it does not matter)
+    /// \return indexes of the clusters. If there are not enough free clusters, it will return an empty vector
+    std::vector<int32_t> getFreeClusters(int32_t n, const INode_t *iNode = NULL);
+
+    /// Releases the clusters given as a parameter (marks them as free in the bitmap)
+    ///
+    /// \param clusters indexes of the clusters
+    void releaseClusters(const std::vector<int32_t> &clusters);
+
 private:
     /// Creates a new file system
     ///
@@ -341,7 +840,8 @@ private:
 
     /// Loads the whole system from the disk
     ///
-    /// This method is called when the program starts.
+    /// This method is called when the program starts. If the file system was
+    /// created by an incompatible version, it is not mounted (#isMounted).
     void loadFileSystemFromDisk();
 
     /// Loads the superblock from the disk
@@ -378,6 +878,9 @@ private:
 
     /// Prints out a directory item (file/folder)
     ///
+    /// The size, the id and the parent are taken from the i-node of the item (held in the memory).
+    /// The type is taken from the item itself, so the disk is read only for the path of a symbolic link.
+    ///
     /// \param directoryItem directory item that is going to be printed out
     void printDirectoryItem(const DirectoryItem_t *directoryItem);
 
@@ -415,21 +918,84 @@ private:
     ///
     /// This method is used when creating a new file/folder
     /// or when a file is being moved to a different directory.
-    ///
+    /// The i-node is claimed (it is no longer free) right away, so it cannot be
+    /// returned to another thread. If it ends up unused, it must be released by #removeINode.
+    ///
+    /// The i-node is taken from the allocation group of the parent directory,
+    /// so the files of a directory stay close to each other. The directories
+    /// within the root directory are spread out over the groups instead.
+    /// If the group is full, the following groups are tried. The parent of a new file
+    /// is set right away, so its clusters are taken from the group of the directory
+    /// (#getAllocationGroupOfClusters) before the file is added into it. The parent of
+    /// a new directory is set only once it's added, as the usage of the tree is
+    /// propagated through the parents of the directories (#addToSubtreeUsage).
+    ///
+    /// \param parentINode i-node of the directory the new i-node goes into (NULL if it does not matter)
+    /// \param isDirectory true/false whether the new i-node is a directory
     /// \return a reference to a free i-node. If all the i-nodes are
     /// occupied at the moment, it will return NULL
-    INode_t *getFreeINode();
+    INode_t *getFreeINode(const INode_t *parentINode = NULL, bool isDirectory = false);
 
+    /// Returns n free i-nodes
+    ///
+    /// The i-nodes are claimed all at once, so either all of them are claimed or none of them.
+    /// The ones that end up unused must be released by #removeINode.
+    ///
+    /// The i-nodes are taken from the allocation group of the parent directory first.
+    ///
+    /// \param n number of i-nodes
+    /// \param parentINode i-node of the directory the i-nodes go into
+    /// \return references to the i-nodes. If there are not enough free i-nodes, it will return an empty vector
+    std::vector<INode_t *> getFreeINodes(int32_t n, const INode_t *parentINode);
 
-    /// Returns a free an index of a free cluster
+    /// Finds a free space for a small file within the clusters shared by small files
     ///
-    /// This method is widely used when importing a new file into
-    /// the virtual file system, as well as when copying a file into
-    /// a different directory.
+    /// The clusters are searched first-fit. If none of them has enough free
+    /// space, a new cluster will be allocated and shared from now on.
     ///
-    /// \return an index of a free cluster. If there are no free clusters
-    /// in the file system, it will return #NULL_POINTER
-    int32_t getFreeCluster();
+    /// \param size size of the file
+    /// \param offset the offset of the space within the cluster will be stored into it
+    /// \return id of the cluster. If there are no free clusters, it will return #NULL_POINTER
+    int32_t allocatePackedSpace(int32_t size, int32_t *offset);
+
+    /// Releases the space of a small file within a shared cluster
+    ///
+    /// If the cluster is not shared by any other file, it will be released as well.
+    ///
+    /// \param cluster id of the shared cluster
+    /// \param offset offset of the file within the cluster
+    /// \return true, if the cluster has been released. Otherwise, false.
+    bool releasePackedSpace(int32_t cluster, int32_t offset);
+
+    /// Stores the content of a small file into a cluster shared by small files
+    ///
+    /// \param iNode i-node of the file (its size must be set)
+    /// \param data content of the file
+    /// \return false, if there is not enough free clusters in the file system. Otherwise, true.
+    bool storePackedContent(INode_t *iNode, const char *data);
+
+    /// Returns the content of a small file stored in a shared cluster
+    ///
+    /// \param iNode i-node of the file
+    /// \return content of the file
+    std::string getPackedContent(INode_t *iNode);
+
+    /// Builds up the occupancy of the clusters shared by small files from the i-nodes
+    void loadPackedClusters();
+
+    /// Returns the type of the i-node as it is stored in directory items
+    ///
+    /// \param iNode i-node of a file, directory or symbolic link
+    /// \return type of the i-node (#ItemType)
+    uint8_t getItemType(const INode_t *iNode) const;
+
+
+    /// Returns the clusters reserved in the caches of all the threads into the bitmap
+    ///
+    /// It's called when the disk runs out of free clusters as well as before
+    /// the bitmap is walked through as a whole (fsck, defrag, stats). The caches
+    /// of the threads that have finished are removed.
+    void returnCachedClusters();
 
     /// Initializes a new root directory
     ///
@@ -437,39 +1003,251 @@ private:
     /// with a new size and all the data structures need to be re-initialized.
     void initializeRootINode();
 
-    /// Assignes direct clusters to an i-node.
+    /// Returns the cluster at the index given as a parameter
     ///
-    /// \param iNode i-node we want to assign direct clusters to
-    /// \return true if everything goes well. False, if there is not enough
-    /// clusters in the file system
-    bool addDirectClustersToINode(INode_t *iNode);
+    /// The index is translated the same way for files and directories - the first
+    /// clusters are stored in the direct pointers, the following ones in the
+    /// first indirect cluster, and the rest of them in the middle clusters
+    /// of the second indirect cluster.
+    ///
+    /// \param iNode i-node we want to get the cluster of
+    /// \param index index of the cluster within the i-node (0,1,...,n)
+    /// \return id of the cluster
+    int32_t getClusterOfINode(INode_t *iNode, int32_t index);
+
+    /// Allocates a new cluster and attaches it to the i-node at the index given as a parameter
+    ///
+    /// The clusters are supposed to be added one by one, as the indirect cluster
+    /// (or a middle cluster) will be allocated when the first cluster is put into it.
+    ///
+    /// \param iNode i-node we want to add the cluster to
+    /// \param index index of the new cluster within the i-node
+    /// \return false, if there is not enough free clusters in the file system. Otherwise, true.
+    bool addClusterToINode(INode_t *iNode, int32_t index);
+
+    /// Releases the last cluster of the i-node
+    ///
+    /// If it was the only cluster in an indirect cluster (or a middle cluster),
+    /// the indirect (middle) cluster will be released as well.
+    ///
+    /// \param iNode i-node we want to remove the cluster from
+    /// \param index index of the last cluster within the i-node
+    void removeClusterFromINode(INode_t *iNode, int32_t index);
 
-    /// Finds out if there is at least n free clusters in te file system
+    /// Returns the number of data clusters the i-node takes up
     ///
-    /// This method is used when importing a file into the file system
-    /// as well as copying a file within the system.
+    /// \param iNode i-node of a file or a directory
+    /// \return number of data clusters of the i-node
+    int32_t getNumberOfClustersOfINode(INode_t *iNode) const;
+
+    /// Returns the number of clusters taken up by the i-node itself
     ///
-    /// \param n number of cluster we requite to be store a file/folder
-    /// \return true, if there is at least n clusters free. Otherwise, false.
-    bool isThereAtLeastNFreeClusters(int32_t n);
+    /// These are the data clusters as well as the indirect (and middle) clusters.
+    /// A file stored inline or in a shared cluster does not take up any cluster of its own.
+    ///
+    /// \param iNode i-node of a file or a directory
+    /// \return number of clusters taken up by the i-node
+    int32_t getNumberOfOccupiedClusters(INode_t *iNode) const;
+
+    /// Adds the size and clusters to the directory and all its parents up to the root directory
+    ///
+    /// \param directoryINode i-node of the directory whose tree has changed
+    /// \param size size (B) that is added (negative if it is subtracted)
+    /// \param clusters number of clusters that are added (negative if they are subtracted)
+    void addToSubtreeUsage(INode_t *directoryINode, int64_t size, int64_t clusters);
+
+    /// Adds (subtracts) the usage of an i-node linked into (unlinked from) the directory to its tree
+    ///
+    /// \param directoryINode i-node of the directory
+    /// \param iNode i-node linked into or unlinked from the directory (a file or a whole directory tree)
+    /// \param linked true if the i-node has been linked into the directory, false if it has been unlinked
+    void updateSubtreeUsage(INode_t *directoryINode, INode_t *iNode, bool linked);
+
+    /// Changes the number of items of the directory given as a parameter
+    ///
+    /// It sets the size of the directory and allocates (releases) clusters so
+    /// the items fit into them. The directory grows by one cluster at a time,
+    /// so it is not limited to the direct clusters.
+    ///
+    /// \param directoryINode i-node of the directory
+    /// \param count new number of items of the directory
+    /// \return false, if there is not enough free clusters in the file system. Otherwise, true.
+    bool resizeDirectory(INode_t *directoryINode, size_t count);
 
     /// Finds out whether or not there is a file/folder in the directory given as a parameter with particular the name
     ///
-    /// \param directoryItems directory items
+    /// \param directoryINode i-node of the directory
     /// \param name name that we want to find out whether or not is already in the folder
     /// \return true, if the name exists withing the folder. Otherwise, false.
-    bool existsInDirectory(DirectoryItems_t *directoryItems, std::string name);
+    bool existsInDirectory(INode_t *directoryINode, std::string name);
+
+    /// Finds an item with the name given as a parameter in the directory
+    ///
+    /// If the directory has a hashed index, it will cost the hash of the name,
+    /// reading the bucket of the index, and reading the item itself. Otherwise,
+    /// the items of the directory will be read cluster by cluster until the
+    /// item is found. The same goes for a directory whose index is corrupted.
+    ///
+    /// \param directoryINode i-node of the directory
+    /// \param name name of the item we are looking for
+    /// \param position if not NULL, the position of the item within the directory will be stored into it
+    /// \return id of the i-node of the item. If there's no such an item, it will return #NULL_POINTER
+    int32_t findInDirectory(INode_t *directoryINode, std::string name, int32_t *position = NULL);
+
+    /// Looks the name given as a parameter up in the directory
+    ///
+    /// The result (including the case when there's no such an item)
+    /// is kept in the dentry cache, so resolving the same name again
+    /// costs no I/O.
+    ///
+    /// \param directoryINode i-node of the directory
+    /// \param name name of the item we are looking for
+    /// \return id of the i-node of the item. If there's no such an item, it will return #NULL_POINTER
+    int32_t lookupInDirectory(INode_t *directoryINode, std::string name);
+
+    /// Stores the result of looking a name up in a directory into the dentry cache
+    ///
+    /// If the cache is full, the least recently used name will be evicted first.
+    ///
+    /// \param directoryId id of the i-node of the directory
+    /// \param name name of the item
+    /// \param iNodeId id of the i-node of the item (#NULL_POINTER if there's no such an item)
+    void cacheDentry(int32_t directoryId, std::string name, int32_t iNodeId);
+
+    /// Removes all the names of the directory given as a parameter from the dentry cache
+    ///
+    /// \param directoryId id of the i-node of the directory
+    void invalidateDentries(int32_t directoryId);
+
+    /// Empties the dentry cache
+    void clearDentryCache();
+
+    /// Returns the number of directory items that fit into one cluster
+    /// \return number of directory items in a cluster
+    inline int32_t getNumberOfItemsInCluster() const;
+
+    /// Returns the address of the directory item at the position given as a parameter
+    ///
+    /// \param directoryINode i-node of the directory
+    /// \param position position of the item within the directory
+    /// \return address of the item within the storage (file)
+    off_t getDirectoryItemOffset(INode_t *directoryINode, int32_t position);
+
+    /// Returns a hash of the name of a directory item (FNV-1a)
+    ///
+    /// \param name name of the directory item
+    /// \return hash of the name
+    uint32_t hashName(const char *name) const;
+
+    /// Creates a (new) hashed index of the directory given as a parameter
+    ///
+    /// The number of buckets is chosen according to the number of
+    /// items in the directory, so the buckets are about half full.
+    /// If the directory already has an index, it will be replaced.
+    ///
+    /// \param directoryINode i-node of the directory
+    void buildDirectoryIndex(INode_t *directoryINode);
+
+    /// Adds an item into the hashed index of the directory
+    ///
+    /// If the directory has just reached #DIR_INDEX_MIN_ITEMS items, the index
+    /// will be created. If the buckets are getting too full (or the index turns
+    /// out to be corrupted), the index will be rebuilt (with more buckets).
+    ///
+    /// \param directoryINode i-node of the directory
+    /// \param name name of the directory item
+    /// \param position position of the item within the directory
+    void addToDirectoryIndex(INode_t *directoryINode, const char *name, int32_t position);
+
+    /// Changes the position of an item in the hashed index of the directory
+    ///
+    /// It is used when an item is removed from the directory and the last
+    /// item of the directory is moved into its slot. If the index turns out
+    /// to be corrupted, it will be removed (and built up again once an item
+    /// is added into the directory).
+    ///
+    /// \param directoryINode i-node of the directory
+    /// \param name name of the directory item
+    /// \param position current position of the item within the directory
+    /// \param newPosition new position of the item. If it's #NULL_POINTER, the item will be removed from the index.
+    void updateDirectoryIndex(INode_t *directoryINode, const char *name, int32_t position, int32_t newPosition);
+
+    /// Returns the first cluster of the bucket of the hashed index the hash given as a parameter falls into
+    ///
+    /// \param directoryINode i-node of the directory (it must have an index)
+    /// \param hash hash of the name (#hashName)
+    /// \param numberOfBuckets if not NULL, the number of buckets of the index will be stored into it
+    /// \return the cluster. If the root of the index is corrupted, it will return #NULL_POINTER
+    int32_t getDirectoryIndexBucket(const INode_t *directoryINode, uint32_t hash, int32_t *numberOfBuckets = NULL);
+
+    /// Reads the header of a cluster of a bucket of the hashed index
+    ///
+    /// The header holds the number of items stored in the cluster and the next cluster of the bucket.
+    /// It's read from the disk, so it's checked before it's used to read the items.
+    ///
+    /// \param cluster the cluster of the bucket
+    /// \param header the header will be stored into it (2 items)
+    /// \return false, if the header is corrupted (e.g. there are more items than fit into the cluster). Otherwise, true.
+    bool readDirectoryIndexHeader(int32_t cluster, int32_t *header);
+
+    /// Removes the hashed index of the directory and releases its clusters
+    ///
+    /// \param directoryINode i-node of the directory
+    void removeDirectoryIndex(INode_t *directoryINode);
+
+    /// Returns all the clusters of the hashed index of the directory (the root and the buckets)
+    ///
+    /// \param iNode i-node of the directory
+    /// \return a vector of all the clusters of the index
+    std::vector<int32_t> getIndexClustersOfINode(INode_t *iNode);
+
+    /// Writes the items of a bucket of the hashed index on the disk
+    ///
+    /// If the items do not fit into one cluster, new (overflow) clusters
+    /// will be chained to the bucket.
+    ///
+    /// \param directoryINode i-node of the directory the index belongs to
+    /// \param cluster the first cluster of the bucket
+    /// \param items items of the bucket
+    /// \return false, if there is not enough free clusters in the file system. Otherwise, true.
+    bool saveDirectoryIndexBucket(const INode_t *directoryINode, int32_t cluster, const std::vector<DirectoryIndexItem_t> &items);
 
     /// Adds the i-node given as a parameter to the particulat directory
     ///
     /// This method is used when adding a new file/folder into the directory
-    /// given as a parameter. 
+    /// given as a parameter. The new item is appended after the last item
+    /// of the directory, so only the cluster it falls into is written.
     ///
-    /// \param directoryItems directory items of the target directory
     /// \param directoryINode i-node of the target directory
     /// \param newINode i-node (file/folder) we are going to add into the directory
     /// \param name of the (file/folder) we are going to add into the directory
-    void addINodeToDirectory(DirectoryItems_t *directoryItems, INode_t *directoryINode, INode_t *newINode, std::string name);
+    /// \return false, if there is not enough free clusters to store the directory. Otherwise, true.
+    bool addINodeToDirectory(INode_t *directoryINode, INode_t *newINode, std::string name);
+
+    /// Adds a new i-node whose content has already been stored into the directory
+    ///
+    /// The directory is locked only while the i-node is being added, so the content
+    /// of the new i-node can be written at the same time as other files are added into
+    /// the directory. The directory might have been removed or the name taken up
+    /// in the meantime, which is checked once the directory is locked.
+    ///
+    /// \param directoryINode i-node of the target directory
+    /// \param newINode i-node (file) we are going to add into the directory
+    /// \param name name of the file
+    /// \return false, if the i-node could not be added. Otherwise, true.
+    bool linkNewINode(INode_t *directoryINode, INode_t *newINode, std::string name);
+
+    /// Stores one directory item on the disk
+    ///
+    /// \param directoryINode i-node of the directory
+    /// \param position position of the item within the directory
+    /// \param item the item itself
+    void saveDirectoryItemOnDisk(INode_t *directoryINode, int32_t position, const DirectoryItem_t *item);
+
+    /// Stores the number of items of the directory (given by its size) on the disk
+    ///
+    /// \param directoryINode i-node of the directory
+    void saveNumberOfDirectoryItemsOnDisk(INode_t *directoryINode);
 
     /// Returns all the clusters of the i-node given as a parameter
     ///
@@ -491,11 +1269,23 @@ private:
     /// Removes the i-node given as a parameter from its parent.
     ///
     /// It means that the i-node will be removed from the directory
-    /// that it is located in.
+    /// that it is located in. The last item of the directory is moved
+    /// into the slot of the removed item, so the order of the items changes.
     ///
     /// \param iNode i-node that is going to be removed from the parent directory
     void removeINodeFromParent(INode_t *iNode);
 
+    /// Removes the item of the i-node given as a parameter from a directory (#removeINodeFromParent)
+    ///
+    /// Unlike #removeINodeFromParent, the parent and the cached name of the i-node are left
+    /// untouched, so the i-node can be linked into another directory before it's removed
+    /// from the original one (#moveFileToADifferentDir).
+    ///
+    /// \param parentINode i-node of the directory the item is removed from
+    /// \param iNode i-node of the item
+    /// \param name name of the item within the directory
+    void removeItemFromDirectory(INode_t *parentINode, INode_t *iNode, std::string name);
+
     /// Removes the i-node given as a parameter from the file system.
     ///
     /// The i-node can be both a directory or a folder, and the method
@@ -525,11 +1315,378 @@ private:
     /// \return an absolute path of the i-node given as a parameter
     std::string getPath(INode_t *iNode);
 
+    /// Returns the name of the i-node within its parent directory
+    ///
+    /// The names are cached, so the parent directory is searched
+    /// only the first time the name is needed. The parent directory
+    /// must be locked by the caller.
+    ///
+    /// \param iNode i-node we want to know the name of
+    /// \return the name of the i-node (an empty string if it's not found in its parent directory)
+    std::string getNameOfINode(INode_t *iNode);
+
     /// Returns the content of the slink given as a parameter (path to the file the slink points at)
     ///
     /// \param iNode symbolic link to a file
     /// \return the content of the symbolic like (an absolute path to a file)
     std::string getPathFromSLink(INode_t *iNode);
+
+    /// Reads data from the storage (file) of the file system
+    ///
+    /// Unlike fseek & fread, the position of the file is not shared,
+    /// so the method can be called from multiple threads at the same time.
+    ///
+    /// \param buff buffer the data is going to be read into
+    /// \param size size of one element
+    /// \param count number of elements
+    /// \param offset position within the storage (file) the data is read from
+    void readFromDisk(void *buff, size_t size, size_t count, off_t offset);
+
+    /// Writes data into the storage (file) of the file system
+    ///
+    /// It is the counterpart of #readFromDisk, so it can be also called from multiple threads
+    /// at the same time (as long as they write into different parts of the storage).
+    ///
+    /// \param buff buffer the data is going to be written from
+    /// \param size size of one element
+    /// \param count number of elements
+    /// \param offset position within the storage (file) the data is written to
+    void writeToDisk(const void *buff, size_t size, size_t count, off_t offset);
+
+    /// Starts a batch of changes
+    ///
+    /// Until the batch is committed (#commitBatch), the i-nodes and the bitmap are
+    /// not stored on the disk every time they change, but only once at the end.
+    void beginBatch();
+
+    /// Commits the batch of changes started by #beginBatch
+    ///
+    /// The i-nodes and the bitmap are stored on the disk if they have been changed within the batch.
+    void commitBatch();
+
+    /// Reads the items of all the directories within the directory tree in parallel
+    ///
+    /// Every directory is read by a task of a thread pool, which adds a new task
+    /// for each of its subdirectories. The first cluster of the subdirectory is
+    /// prefetched at the same time, so it is likely to be cached once the task runs.
+    ///
+    /// \param directoryINode i-node of the root directory of the tree
+    /// \return items of the directories (i-node of the directory -> its items without '.' and '..')
+    std::unordered_map<int32_t, std::vector<DirectoryItem_t>> readDirectoryTree(INode_t *directoryINode);
+
+    /// Creates a new empty folder in the directory given as a parameter
+    ///
+    /// Unlike #addNewFolder, it does not inform the user about the result.
+    ///
+    /// \param destinationINode i-node of the directory the folder is going to be created in
+    /// \param folderName name of the folder
+    /// \return i-node of the new folder. If the folder could not be created, it will return NULL
+    INode_t *createFolder(INode_t *destinationINode, std::string folderName);
+
+    /// Creates a new empty folder in the directory given as a parameter using an i-node that has already been claimed
+    ///
+    /// If the folder could not be created, the i-node will be released.
+    ///
+    /// \param newFolderINode claimed i-node of the new folder
+    /// \param destinationINode i-node of the directory the folder is going to be created in
+    /// \param folderName name of the folder
+    /// \return false, if the folder could not be created. Otherwise, true.
+    bool initFolder(INode_t *newFolderINode, INode_t *destinationINode, std::string folderName);
+
+    /// Walks through the directory tree on the HDD given as a parameter
+    ///
+    /// The tree is walked breadth-first, so every directory comes before its items. The items
+    /// of a directory are sorted by their names. Other items than regular files and directories
+    /// (e.g. symbolic links) are skipped.
+    ///
+    /// \param path path to the directory on the HDD
+    /// \param name name of the directory within the file system
+    /// \param items the items of the tree will be stored into it (the directory itself goes first)
+    /// \return false, if the path is not a directory or it cannot be read. Otherwise, true.
+    bool readHostDirectoryTree(std::string path, std::string name, std::vector<ImportedItem_t> &items);
+
+    /// Imports the content of a file of a directory tree being imported from the HDD (#incpyDirectory)
+    ///
+    /// It is executed by a task of the batch given as a parameter. The content of a large
+    /// file is written by new tasks of the batch, one for each run of clusters.
+    ///
+    /// \param item the imported file (its i-node must be claimed)
+    /// \param tasks batch of the thread pool the content of the file is written by
+    /// \param failed set by the tasks writing the content if a part of the file cannot be read (the batch must be waited for)
+    /// \return false, if there is not enough free clusters in the file system or the file cannot be read. Otherwise, true.
+    bool importHostFile(const ImportedItem_t &item, ThreadPool::Batch &tasks, std::atomic<bool> &failed);
+
+    /// Writes a file of a directory tree being exported onto the HDD (#outcpyDirectory)
+    ///
+    /// The content is read in runs of consecutive clusters (at most #COPY_RUN_LEN clusters long).
+    ///
+    /// \param iNode i-node of the file
+    /// \param clusters clusters of the file (#getAllClustersOfINode)
+    /// \param path path to the file on the HDD
+    /// \return false, if the file cannot be written. Otherwise, true.
+    bool exportFile(INode_t *iNode, const std::vector<int32_t> &clusters, std::string path);
+
+    /// Writes the content of a file on the HDD into the clusters given as a parameter
+    ///
+    /// The file is read and written at the same time. A reader thread reads the file
+    /// into a ring of #IMPORT_BUFFER_COUNT buffers, while the calling thread writes the
+    /// buffers that have been read into the clusters. Consecutive clusters are written
+    /// at once. A file fitting into a single buffer is read and written right away.
+    /// If the file cannot be read whole (e.g. it has shrunk in the meantime), both
+    /// threads stop and the content of the clusters is left incomplete.
+    ///
+    /// \param sourceFile the file on the HDD (read from its beginning)
+    /// \param fileSize size of the file
+    /// \param clusters clusters the content is written into
+    /// \return false, if the file cannot be read. Otherwise, true.
+    bool importFileContent(FILE *sourceFile, size_t fileSize, const std::vector<int32_t> &clusters);
+
+    /// Writes the content of a buffer into the clusters given as a parameter
+    ///
+    /// \param buff the content
+    /// \param length size of the content
+    /// \param clusters clusters the content is written into (the first one is given by the next parameter)
+    /// \param first index of the first cluster the content is written into
+    void writeBuffer(const char *buff, size_t length, const std::vector<int32_t> &clusters, size_t first);
+
+    /// Hints the storage of the file system that the clusters given as a parameter are going to be read soon
+    ///
+    /// The clusters are merged into runs of consecutive clusters, so there is one hint per run.
+    ///
+    /// \param clusters indexes of the clusters
+    void prefetchClusters(const std::vector<int32_t> &clusters);
+
+    /// Creates a copy of the file for the directory given as a parameter
+    ///
+    /// The clusters of the copy are allocated, but the content itself is not copied.
+    /// Instead, pairs of the source and destination clusters are added into the vector
+    /// given as a parameter, so the content can be copied later on (#copyClusters).
+    /// The copy is not added into the directory, so it must be added once its content
+    /// has been copied (#addINodeToDirectory) or removed (#removeINode).
+    ///
+    /// \param fileINode i-node of the source file
+    /// \param destinationINode i-node of the destination directory
+    /// \param clusterCopies pairs of clusters (source, destination) that need to be copied
+    /// \return i-node of the copy. If the file could not be copied, it will return NULL
+    INode_t *copyINode(INode_t *fileINode, INode_t *destinationINode, std::vector<std::pair<int32_t, int32_t>> &clusterCopies);
+
+    /// Creates a copy of the directory tree (or a file) in the directory given as a parameter
+    ///
+    /// The directories are created right away, the copies of the files are only
+    /// collected, so they can be added into their directories later on (#copyINode).
+    ///
+    /// \param iNode i-node of the source directory/file
+    /// \param destinationINode i-node of the destination directory
+    /// \param name name of the copy
+    /// \param tree items of the directories of the source tree (#readDirectoryTree)
+    /// \param clusterCopies pairs of clusters (source, destination) that need to be copied
+    /// \param copiedFiles copies of the files that need to be added into their directories once their content is copied
+    /// \return false, if some of the files or directories could not be copied. Otherwise, true.
+    bool copyTree(INode_t *iNode, INode_t *destinationINode, std::string name, const std::unordered_map<int32_t, std::vector<DirectoryItem_t>> &tree,
+                  std::vector<std::pair<int32_t, int32_t>> &clusterCopies, std::vector<CopiedFile_t> &copiedFiles);
+
+    /// Copies the content of the clusters
+    ///
+    /// The pairs are sorted and merged into runs of consecutive clusters (at most #COPY_RUN_LEN clusters long),
+    /// which are then copied by the tasks of a thread pool.
+    ///
+    /// \param clusterCopies pairs of clusters (source, destination) that need to be copied
+    void copyClusters(std::vector<std::pair<int32_t, int32_t>> clusterCopies);
+
+    /// Returns the indirect clusters of the i-node given as a parameter
+    ///
+    /// These are the clusters that do not hold the content of the file
+    /// but the pointers to the clusters. That is the first indirect
+    /// cluster, the second indirect cluster and all the middle clusters
+    /// the second indirect cluster points at.
+    ///
+    /// \param iNode i-node we want to get the indirect clusters of
+    /// \return a vector of all the indirect clusters of the i-node
+    std::vector<int32_t> getIndirectClustersOfINode(INode_t *iNode);
+
+    /// Checks a single i-node when checking the consistency of the file system
+    ///
+    /// It validates all the pointers of the i-node and collects
+    /// all the clusters the i-node occupies. If the i-node is a directory,
+    /// it also loads and validates its items.
+    ///
+    /// \param iNode i-node that is going to be checked
+    /// \param checked collected information about the i-node
+    void checkINode(INode_t *iNode, CheckedINode_t &checked);
+
+    /// Returns true if the cluster given as a parameter is a valid index of a cluster
+    ///
+    /// \param cluster index of the cluster
+    /// \return true, if the index is within the range of clusters. Otherwise, false.
+    inline bool isValidCluster(int32_t cluster) const;
+
+    /// Returns true if the i-node given as a parameter is located within the directory given as a parameter
+    ///
+    /// It goes up from the i-node towards the root directory following
+    /// the parent ids. The i-node is also considered to be located within
+    /// the directory if the directory is the i-node itself.
+    ///
+    /// \param iNode i-node we want to find out the location of
+    /// \param directoryINode i-node of the directory
+    /// \return true, if the i-node is located within the directory (subtree). Otherwise, false.
+    bool isInSubtree(INode_t *iNode, INode_t *directoryINode);
+
+    /// Returns the number of fragments of the clusters given as a parameter
+    ///
+    /// A fragment is a run of clusters following each other on the disk.
+    /// Therefore, the clusters of a file stored contiguously form one fragment.
+    ///
+    /// \param clusters clusters of a file
+    /// \return number of fragments
+    int32_t getNumberOfFragments(const std::vector<int32_t> &clusters) const;
+
+    /// Tells if the cluster given as a parameter is free
+    /// \param cluster index of the cluster
+    /// \return true, if the cluster is free in the bitmap. Otherwise, false.
+    bool isClusterFree(int32_t cluster) const;
+
+    /// Marks the cluster given as a parameter as free or used in the bitmap
+    ///
+    /// \param cluster index of the cluster
+    /// \param free true/false whether the cluster is free
+    void setClusterFree(int32_t cluster, bool free);
+
+    /// Claims up to n free clusters in the bitmap
+    ///
+    /// The free clusters of a word of the bitmap are claimed at once
+    /// by compare-and-swap, so no lock is needed. The search starts
+    /// in the allocation group given as a parameter from the word the
+    /// last search within the group ended in. The groups without any
+    /// free clusters are skipped.
+    ///
+    /// \param n maximum number of clusters
+    /// \param group the allocation group the search starts in
+    /// \param clusters the claimed clusters are appended to it
+    void claimFreeClusters(int32_t n, int32_t group, std::vector<int32_t> &clusters);
+
+    /// Claims n free clusters in the bitmap (all or none of them)
+    ///
+    /// \param n number of clusters
+    /// \param group the allocation group the search starts in
+    /// \return indexes of the clusters. If there are not enough free clusters, it will return an empty vector
+    std::vector<int32_t> claimClusters(int32_t n, int32_t group);
+
+    /// Splits the clusters and the i-nodes into allocation groups
+    ///
+    /// A group has #ALLOCATION_GROUP_LEN clusters (the last one might have fewer)
+    /// and the i-nodes are split evenly among the groups. The groups are not stored
+    /// on the disk as they are given by the size of the disk.
+    void initAllocationGroups();
+
+    /// Returns the allocation group of the i-node given as a parameter
+    /// \param iNodeId id of the i-node
+    /// \return index of the allocation group
+    int32_t getAllocationGroupOfINode(int32_t iNodeId) const;
+
+    /// Returns the allocation group of the cluster given as a parameter
+    /// \param cluster index of the cluster
+    /// \return index of the allocation group
+    int32_t getAllocationGroupOfCluster(int32_t cluster) const;
+
+    /// Returns the allocation group the clusters of the i-node given as a parameter are taken from
+    ///
+    /// The clusters of a file are taken from the group of its parent directory, so the files
+    /// of a directory are stored close to each other even if their i-nodes have been taken
+    /// from different groups. The clusters of a directory are taken from the group of its own
+    /// i-node, which is where the directory has been placed (#getAllocationGroupOfNewINode).
+    ///
+    /// \param iNode the i-node (NULL if it does not matter)
+    /// \return index of the allocation group
+    int32_t getAllocationGroupOfClusters(const INode_t *iNode) const;
+
+    /// Returns the allocation group a new i-node is going to be taken from
+    ///
+    /// \param parentINode i-node of the directory the new i-node goes into (NULL if it does not matter)
+    /// \param isDirectory true/false whether the new i-node is a directory
+    /// \return index of the allocation group
+    int32_t getAllocationGroupOfNewINode(const INode_t *parentINode, bool isDirectory) const;
+
+    /// Returns the cache of clusters of the calling thread
+    ///
+    /// If the thread does not have a cache for this disk yet, a new one is created.
+    ///
+    /// \return the cache of clusters of the thread
+    AllocationCache_t *getAllocationCache();
+
+    /// Copies the bitmap into an array of flags (true means a free cluster)
+    ///
+    /// The clusters reserved in the caches of the threads are free
+    /// as they are not used by any i-node. It's the format the bitmap
+    /// is stored on the disk in. The caller must hold #allocatorMutex.
+    ///
+    /// \return the flags of all the clusters
+    std::vector<char> getBitmapFlags();
+
+    /// Sets the bitmap according to the flags given as a parameter (true means a free cluster)
+    /// \param flags the flags of all the clusters
+    void setBitmapFlags(const std::vector<char> &flags);
+
+    /// Returns the first cluster of a contiguous run of n free clusters
+    ///
+    /// \param n number of free clusters following each other
+    /// \return index of the first cluster of the run. If there is no such run, it will return #NULL_POINTER
+    int32_t getFreeRunOfClusters(int32_t n);
+
+    /// Relocates the file given as a parameter into a contiguous run of clusters.
+    ///
+    /// First, the content of the file is copied into the new clusters, then the pointers
+    /// of the i-node are rewritten and the original clusters released. If the pointers
+    /// cannot be rewritten, the i-node is left as it was and the new clusters are released.
+    ///
+    /// The content is copied chunk by chunk. If the deadline passes before the whole file
+    /// is copied, the copying is continued by the next call (#defragRunStart). The file is
+    /// checked not to have been changed in the meantime.
+    ///
+    /// \param iNode i-node of the file that is going to be relocated
+    /// \param deadline time the copying is interrupted at
+    /// \return true, if the file was relocated. False, if it's not fragmented, there is no contiguous run big enough, or it has not been copied yet.
+    bool defragmentFile(INode_t *iNode, std::chrono::steady_clock::time_point deadline);
+
+    /// Abandons the file that is being copied by the defragmentation (if there's any)
+    ///
+    /// The run of clusters the file was being copied into is released.
+    void cancelRelocation();
+
+    /// Relocates the fragmented files one by one until the time budget runs out (#defragmentStep)
+    ///
+    /// The lock of the directory tree must be held exclusively by the caller.
+    ///
+    /// \param timeBudget time budget in milliseconds
+    /// \return true, if there is still some work left. Otherwise (the defragmentation has finished), false.
+    bool continueDefragmentation(int32_t timeBudget);
+
+    /// Returns the i-node of the current directory of the calling thread (session)
+    /// \return i-node of the current directory
+    INode_t *getCurrentINode();
+
+    /// Sets the current directory of the calling thread (session)
+    ///
+    /// \param iNode i-node of the new current directory
+    void setCurrentINode(INode_t *iNode);
+
+    /// Returns true if the current directory of any session is located within the directory given as a parameter
+    ///
+    /// \param directoryINode i-node of the directory
+    /// \return true, if some session is located within the directory (subtree). Otherwise, false.
+    bool isWorkingDirectoryInSubtree(INode_t *directoryINode);
+
+    /// Locks the i-node as well as its parent directory exclusively
+    ///
+    /// Directories are locked in the order of their ids, and a file is locked
+    /// after its parent directory, so the locks are always taken in the same global
+    /// order (see #moveFileToADifferentDir). As the i-node was looked up before
+    /// it got locked, it might have been removed or moved in the meantime.
+    ///
+    /// \param iNode i-node that is going to be locked
+    /// \param parentLock lock of the parent directory
+    /// \param lock lock of the i-node
+    /// \return false, if the i-node is no longer linked in the same directory. Otherwise, true.
+    bool lockWithParent(INode_t *iNode, ExclusiveLock_t &parentLock, ExclusiveLock_t &lock);
 };
 
 #endif
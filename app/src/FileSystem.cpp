@@ -5,6 +5,8 @@ FileSystem::FileSystem(std::string diskFileName) {
 }
 
 FileSystem::~FileSystem() {
+    // the asynchronous operations must not outlive the disk
+    executor.reset();
     if (disk != NULL)
         delete disk;
 }
@@ -13,9 +15,19 @@ std::string FileSystem::getCurrentPath() const {
     return disk->getCurrentPath();
 }
 
-void FileSystem::rm(std::string path) {
+bool FileSystem::isMounted() const {
+    return disk->isMounted();
+}
+
+void FileSystem::closeSession() {
+    disk->closeSession();
+}
+
+void FileSystem::rm(std::string path, bool recursive) {
     Disk::INode_t *fileINode = disk->getINodeFromPath(path);
-    disk->removeFile(fileINode);
+    if (recursive)
+        disk->removeDirectoryRecursively(fileINode);
+    else disk->removeFile(fileINode);
 }
 
 void FileSystem::mkdir(std::string path) {
@@ -56,33 +68,35 @@ void FileSystem::ls(std::string path) {
     else {
         Disk::INode_t *directoryINode = disk->getINodeFromPath(path);
         if (directoryINode == NULL) {
-            USER_ALERT("PATH NOT FOUND");
+            USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
             return;
         }
         if (directoryINode->isDirectory == false) {
-            USER_ALERT("TARGET IS NOT A DIRECTORY");
+            USER_ALERT(Logger::STATUS_NOT_A_DIRECTORY);
             return;
         }
-        Disk::DirectoryItems_t *directoryItems = disk->getDirectoryItemsFromINode(directoryINode);
-        disk->printDirectoryItems(directoryItems);
-        delete directoryItems;
+        disk->printDirectoryItems(directoryINode);
     }
 }
 
 void FileSystem::pwd() {
-    std::cout << disk->getCurrentPath() << "\n";
+    Logger::getOutput() << disk->getCurrentPath() << "\n";
 }
 
 void FileSystem::cat(std::string path) {
     Disk::INode_t *fileInode = disk->getINodeFromPath(path);
-    disk->printFileContent(fileInode, true);
+    disk->printFileContent(fileInode, true, Logger::getOutput());
 }
 
 void FileSystem::incpy(std::string source) {
     incpy(source, getCurrentPath());
 }
 
-void FileSystem::incpy(std::string source, std::string destination) {
+void FileSystem::incpy(std::string source, std::string destination, bool recursive) {
+    // 'incp -r test_files/ /' imports the directory test_files
+    while (recursive && source.length() > 1 && source.back() == '/')
+        source.pop_back();
+
     std::string fileName = getDestinationFileName(source, destination);
     fileName = disk->normalizeName(fileName);
     std::string destinationPath = getDestinationDirectoryPath(destination);
@@ -90,6 +104,12 @@ void FileSystem::incpy(std::string source, std::string destination) {
     if (destinationPath == "")
         destinationPath = "/";
 
+    if (recursive) {
+        Disk::INode_t *destinationINode = disk->getINodeFromPath(destinationPath);
+        disk->incpyDirectory(destinationINode, source, fileName);
+        return;
+    }
+
     // open the source file stored on the HDD as a binary file
     FILE *file = fopen(source.c_str(), "rb+");
     Disk::INode_t *destinationINode = disk->getINodeFromPath(destinationPath);
@@ -99,12 +119,21 @@ void FileSystem::incpy(std::string source, std::string destination) {
         fclose(file);
 }
 
-void FileSystem::outcpy(std::string source, std::string destination) {
+void FileSystem::outcpy(std::string source, std::string destination, bool recursive) {
+    if (recursive) {
+        // 'outcp -r /Documents backup/' creates the directory backup
+        while (destination.length() > 1 && destination.back() == '/')
+            destination.pop_back();
+        Disk::INode_t *sourceINode = disk->getINodeFromPath(source);
+        disk->outcpyDirectory(sourceINode, destination);
+        return;
+    }
+
     // create an empty file that's going to be used
     // as a target file
     FILE *targetFile = fopen(destination.c_str(),"w");
     if (targetFile == NULL) {
-        USER_ALERT("PATH NOT FOUND");
+        USER_ALERT(Logger::STATUS_PATH_NOT_FOUND);
         return;
     }
     fclose(targetFile);
@@ -121,7 +150,7 @@ void FileSystem::format(size_t size) {
     disk->format(size);
 }
 
-void FileSystem::cp(std::string source, std::string destination) {
+void FileSystem::cp(std::string source, std::string destination, bool recursive) {
     // get the destination file and path
     std::string fileName = getDestinationFileName(source, destination);
     std::string destinationPath = getDestinationDirectoryPath(destination);
@@ -132,7 +161,9 @@ void FileSystem::cp(std::string source, std::string destination) {
 
     Disk::INode_t *sourceINode = disk->getINodeFromPath(source);
     Disk::INode_t *destinationINode = disk->getINodeFromPath(destinationPath);
-    disk->copyFileToADifferentDirectory(sourceINode, destinationINode, fileName);
+    if (recursive)
+        disk->copyDirectoryToADifferentDirectory(sourceINode, destinationINode, fileName);
+    else disk->copyFileToADifferentDirectory(sourceINode, destinationINode, fileName);
 }
 
 void FileSystem::mv(std::string source, std::string destination) {
@@ -149,6 +180,106 @@ void FileSystem::mv(std::string source, std::string destination) {
     disk->moveFileToADifferentDir(sourceINode, destinationINode, fileName);
 }
 
+void FileSystem::find(std::string path, std::string pattern, std::string size) {
+    int64_t minSize = 0;
+    int64_t maxSize = INT64_MAX;
+    if (size.empty() == false) {
+        // larger than ('+n'), smaller than ('-n'), or exactly ('n')
+        int64_t value = std::stoll(size[0] == '+' || size[0] == '-' ? size.substr(1) : size);
+        if (size[0] == '+')
+            minSize = value + 1;
+        else if (size[0] == '-')
+            maxSize = value - 1;
+        else minSize = maxSize = value;
+    }
+    Disk::INode_t *directoryINode = disk->getINodeFromPath(path);
+    disk->find(directoryINode, pattern, minSize, maxSize);
+}
+
+void FileSystem::du(std::string path) {
+    if (path.empty())
+        path = ".";
+    Disk::INode_t *iNode = disk->getINodeFromPath(path);
+    disk->printDiskUsage(iNode);
+}
+
+std::future<Logger::Status> FileSystem::incpyAsync(std::string source, std::string destination, bool recursive) {
+    destination = getAbsolutePath(destination);
+    return runAsync<Logger::Status>([this, source, destination, recursive]() {
+        return performSilently([&]() { incpy(source, destination, recursive); });
+    });
+}
+
+std::future<Logger::Status> FileSystem::outcpyAsync(std::string source, std::string destination, bool recursive) {
+    source = getAbsolutePath(source);
+    return runAsync<Logger::Status>([this, source, destination, recursive]() {
+        return performSilently([&]() { outcpy(source, destination, recursive); });
+    });
+}
+
+std::future<Logger::Status> FileSystem::cpAsync(std::string source, std::string destination, bool recursive) {
+    source = getAbsolutePath(source);
+    destination = getAbsolutePath(destination);
+    return runAsync<Logger::Status>([this, source, destination, recursive]() {
+        return performSilently([&]() { cp(source, destination, recursive); });
+    });
+}
+
+std::future<Logger::Status> FileSystem::mvAsync(std::string source, std::string destination) {
+    source = getAbsolutePath(source);
+    destination = getAbsolutePath(destination);
+    return runAsync<Logger::Status>([this, source, destination]() {
+        return performSilently([&]() { mv(source, destination); });
+    });
+}
+
+std::future<Logger::Status> FileSystem::rmAsync(std::string path, bool recursive) {
+    path = getAbsolutePath(path);
+    return runAsync<Logger::Status>([this, path, recursive]() {
+        return performSilently([&]() { rm(path, recursive); });
+    });
+}
+
+std::future<Logger::Status> FileSystem::mkdirAsync(std::string path) {
+    path = getAbsolutePath(path);
+    return runAsync<Logger::Status>([this, path]() {
+        return performSilently([&]() { mkdir(path); });
+    });
+}
+
+std::future<FileSystem::ReadResult_t> FileSystem::readAsync(std::string path) {
+    path = getAbsolutePath(path);
+    return runAsync<ReadResult_t>([this, path]() {
+        std::ostringstream content;
+        ReadResult_t result;
+        result.status = performSilently([&]() {
+            disk->printFileContent(disk->getINodeFromPath(path), true, content);
+        });
+        if (result.status == Logger::STATUS_OK)
+            result.content = content.str();
+        return result;
+    });
+}
+
+Logger::Status FileSystem::performSilently(std::function<void()> operation) {
+    if (isMounted() == false)
+        return Logger::STATUS_INCOMPATIBLE_FILE_SYSTEM;
+    // a stream with no buffer discards everything written into it
+    std::ostream discarded(NULL);
+    Logger::setOutput(&discarded);
+    Logger::setLastStatus(Logger::STATUS_FAILED);
+    operation();
+    Logger::setOutput(NULL);
+    return Logger::getLastStatus();
+}
+
+std::string FileSystem::getAbsolutePath(std::string path) const {
+    if (path.empty() == false && path[0] == '/')
+        return path;
+    // the current path always ends with '/'
+    return getCurrentPath() + path;
+}
+
 std::string FileSystem::getSourceFileName(std::string source) {
     size_t pos = source.find_last_of("/");
     if (pos == std::string::npos)
@@ -193,3 +324,25 @@ void FileSystem::slink(std::string file, std::string name) {
     Disk::INode_t *iNode = disk->getINodeFromPath(file);
     disk->createSymbolicLink(iNode, name);
 }
+
+void FileSystem::fsck(bool repair) {
+    disk->checkFileSystem(repair);
+}
+
+void FileSystem::defrag(std::string path) {
+    if (path.empty())
+        path = "/";
+    Disk::INode_t *iNode = disk->getINodeFromPath(path);
+    disk->defragment(iNode);
+}
+
+bool FileSystem::defragStep() {
+    return disk->defragmentStep(DEFRAG_TIME_BUDGET);
+}
+
+void FileSystem::stats(std::string path) {
+    if (path.empty())
+        path = "/";
+    Disk::INode_t *iNode = disk->getINodeFromPath(path);
+    disk->printStatistics(iNode);
+}
@@ -5,9 +5,14 @@
 #include <memory>
 #include <string>
 #include <fstream>
+#include <sstream>
+#include <future>
+#include <mutex>
+#include <functional>
 
 #include "Disk.h"
 #include "Logger.h"
+#include "ThreadPool.h"
 
 /// \author A127B0362P silhavyj
 ///
@@ -16,11 +21,24 @@
 /// The class directly interacts with class #Disk, which represents
 /// a virtual disk of the file system
 class FileSystem {
+public:
+    /// Result of reading the content of a file asynchronously (#readAsync)
+    struct ReadResult_t {
+        Logger::Status status; ///< status of the operation
+        std::string content;   ///< content of the file (empty if the status is not #Logger::STATUS_OK)
+    };
+
 private:
     /// an instance of class #Disk, which represents
     /// a virtual disk of the file system
     Disk *disk = NULL;
 
+    /// executor of the asynchronous operations (created once it is needed)
+    std::unique_ptr<ThreadPool> executor;
+
+    /// makes sure the executor is created only once
+    std::once_flag executorCreated;
+
 private:
     /// Returns a destination file name from the path given as a parameter.
     ///
@@ -62,6 +80,49 @@ private:
     /// \return source file (the end of the path)
     std::string getSourceFileName(std::string source);
 
+    /// Returns an absolute path to the item given as a parameter
+    ///
+    /// A relative path is resolved against the current location of the calling
+    /// thread, so an asynchronous operation performed by the executor works with
+    /// the location the caller had when they started it.
+    ///
+    /// \param path (absolute/relative) path within the file system
+    /// \return the absolute path
+    std::string getAbsolutePath(std::string path) const;
+
+    /// Performs the operation given as a parameter by the executor
+    ///
+    /// The worker performing the operation takes the current location of the calling
+    /// thread over for the time of the operation, so the checks depending on it (e.g.
+    /// removing the current directory) see the location of the caller.
+    ///
+    /// \param operation the operation that is going to be performed
+    /// \return the future holding the result of the operation
+    template<class Result_t>
+    std::future<Result_t> runAsync(std::function<Result_t()> operation) {
+        auto task = std::make_shared<std::packaged_task<Result_t()>>(operation);
+        std::future<Result_t> result = task->get_future();
+        std::call_once(executorCreated, [this]() {
+            executor.reset(new ThreadPool);
+        });
+        int32_t workingDirectory = disk->getWorkingDirectory();
+        executor->addTask([this, task, workingDirectory]() {
+            disk->setWorkingDirectory(workingDirectory);
+            (*task)();
+            disk->closeSession();
+        });
+        return result;
+    }
+
+    /// Performs the operation given as a parameter without printing anything out
+    ///
+    /// The messages for the user are replaced by the status the operation
+    /// reports (#Logger::getLastStatus).
+    ///
+    /// \param operation the operation that is going to be performed
+    /// \return the status of the operation (#Logger::STATUS_FAILED if it has not reported any)
+    Logger::Status performSilently(std::function<void()> operation);
+
 public:
     /// Constructor of the class - creates an instance of it.
     ///
@@ -71,7 +132,8 @@ public:
     /// Destructor of the class.
     ///
     /// Is deletes all dynamically allocated structures
-    /// from the memory.
+    /// from the memory. The asynchronous operations that
+    /// have been started are finished first.
     ~FileSystem();
 
     /// Copy constructor of the class.
@@ -90,14 +152,26 @@ public:
     /// \return current path
     std::string getCurrentPath() const;
 
+    /// Returns true if the file system can be used (see #Disk::isMounted)
+    /// \return false, if the disk holds an incompatible file system. Otherwise, true.
+    bool isMounted() const;
+
+    /// Ends the session of the calling thread
+    ///
+    /// The current location of the thread is forgotten, so the next
+    /// session run by the thread starts in the root directory.
+    void closeSession();
+
     /// Removes a file from the file system.
     /// ### Example
     /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     /// rm img01.png
     /// rm ../../doc/img01.png
+    /// rm -r Documents
     /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     /// \param path (absolute/relative) to the target file
-    void rm(std::string path);
+    /// \param recursive true/false whether a directory should be removed including its content
+    void rm(std::string path, bool recursive = false);
 
     /// Creates a new directory in the location given as a parameter.
     /// ### Example
@@ -167,20 +241,24 @@ public:
     /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     /// incp test_files/data.txt Documents/data_copied.txt
     /// incp test_files/data.txt Documents/
+    /// incp -r test_files Documents/test_files
     /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     /// \param source path (absolute/relative) to the source file on the HDD
     /// \param destination target destination within the file system
-    void incpy(std::string source, std::string destination);
+    /// \param recursive true/false whether a directory should be imported including its content
+    void incpy(std::string source, std::string destination, bool recursive = false);
 
     /// Exports the file from the file system onto the HDD.
     /// ### Example
     /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     /// outcp test_files/data.txt data_exported.txt
     /// outcp data.txt Documents/data_exported.txt
+    /// outcp -r /Documents backup/Documents
     /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     /// \param source path (absolute/relative) to the source file within the file system
     /// \param destination path (absolute/relative) to the target file on the HDD
-    void outcpy(std::string source, std::string destination);
+    /// \param recursive true/false whether a directory should be exported including its content
+    void outcpy(std::string source, std::string destination, bool recursive = false);
 
     /// Formats the disk with a new size given as a parameter (B).
     /// ### Example
@@ -199,10 +277,12 @@ public:
     /// cp data1.txt data2.txt
     /// cp data1.txt Documents/data2.txt
     /// cp ../data1.txt data2.txt
+    /// cp -r Documents Backup/Documents
     /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     /// \param source path (absolute/relative) to the source file within the file system
     /// \param destination path (absolute/relative) to the target file within the file system
-    void cp(std::string source, std::string destination);
+    /// \param recursive true/false whether a directory should be copied including its content
+    void cp(std::string source, std::string destination, bool recursive = false);
 
     /// Movies the file within the file system. It can be also used for renaming files.
     /// ### Example
@@ -234,6 +314,123 @@ public:
     /// \param file target file the symbolic link will be pointing at
     /// \param name of the symbolic link
     void slink(std::string file, std::string name);
+
+    /// Checks the consistency of the file system.
+    /// ### Example
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// fsck
+    /// fsck -r
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// \param repair true/false whether leaked clusters and orphan i-nodes should be repaired
+    void fsck(bool repair);
+
+    /// Defragments the files within the directory (the whole file system if no path is given).
+    ///
+    /// Fragmented files are relocated into contiguous runs of clusters. If it takes longer
+    /// than the time budget, the defragmentation will continue in the background
+    /// while the shell is waiting for another command (#defragStep).
+    /// ### Example
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// defrag
+    /// defrag /videa
+    /// defrag /videa/vid1.wbm
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// \param path (absolute/relative) to the target directory/file
+    void defrag(std::string path);
+
+    /// Performs one step of the defragmentation started by command defrag.
+    /// \return true, if there is still some work left. Otherwise, false.
+    bool defragStep();
+
+    /// Prints out fragmentation and space-usage statistics of the files within the directory
+    /// as well as of the whole volume (the whole file system if no path is given).
+    /// ### Example
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// stats
+    /// frag /videa
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// \param path (absolute/relative) to the target directory/file
+    void stats(std::string path);
+
+    /// Prints out the paths of the files and folders within the directory whose names match the pattern.
+    ///
+    /// The size is given in bytes. '+n' means larger than n, '-n' smaller than n,
+    /// and 'n' exactly n. If the size is given, only files are printed out.
+    /// ### Example
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// find / -name *.txt
+    /// find /videa -name vid? -size +1000000
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// \param path (absolute/relative) to the directory the search starts in
+    /// \param pattern pattern of the names (wildcards '*', '?' and '[...]')
+    /// \param size size of the files (empty if the size does not matter)
+    void find(std::string path, std::string pattern, std::string size);
+
+    /// Prints out the total size and the number of clusters of the directory tree (the current directory if no path is given).
+    /// ### Example
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// du
+    /// du /videa
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// \param path (absolute/relative) to the target directory/file
+    void du(std::string path);
+
+    /// Imports the file (directory) into the file system asynchronously (#incpy).
+    ///
+    /// Nothing is printed out. The status of the operation
+    /// is given by the future instead.
+    /// ### Example
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// std::future<Logger::Status> status = fs.incpyAsync("test_files/data.txt", "Documents/");
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// \param source path (absolute/relative) to the source file on the HDD
+    /// \param destination target destination within the file system
+    /// \param recursive true/false whether a directory should be imported including its content
+    /// \return the future holding the status of the operation
+    std::future<Logger::Status> incpyAsync(std::string source, std::string destination, bool recursive = false);
+
+    /// Exports the file (directory) from the file system onto the HDD asynchronously (#outcpy).
+    /// \param source path (absolute/relative) to the source file within the file system
+    /// \param destination path (absolute/relative) to the target file on the HDD
+    /// \param recursive true/false whether a directory should be exported including its content
+    /// \return the future holding the status of the operation
+    std::future<Logger::Status> outcpyAsync(std::string source, std::string destination, bool recursive = false);
+
+    /// Copies the file (directory) within the file system asynchronously (#cp).
+    /// \param source path (absolute/relative) to the source file within the file system
+    /// \param destination path (absolute/relative) to the target file within the file system
+    /// \param recursive true/false whether a directory should be copied including its content
+    /// \return the future holding the status of the operation
+    std::future<Logger::Status> cpAsync(std::string source, std::string destination, bool recursive = false);
+
+    /// Moves the file within the file system asynchronously (#mv).
+    /// \param source path (absolute/relative) to the source file within the file system
+    /// \param destination path (absolute/relative) to the target file within the file system
+    /// \return the future holding the status of the operation
+    std::future<Logger::Status> mvAsync(std::string source, std::string destination);
+
+    /// Removes the file (directory) from the file system asynchronously (#rm).
+    /// \param path (absolute/relative) to the target file
+    /// \param recursive true/false whether a directory should be removed including its content
+    /// \return the future holding the status of the operation
+    std::future<Logger::Status> rmAsync(std::string path, bool recursive = false);
+
+    /// Creates a new directory asynchronously (#mkdir).
+    /// \param path (absolute/relative) to the target directory including the name
+    /// \return the future holding the status of the operation
+    std::future<Logger::Status> mkdirAsync(std::string path);
+
+    /// Reads the content of the file asynchronously (#cat).
+    ///
+    /// Symbolic links are followed. Unlike cat, the content
+    /// is returned rather than printed out.
+    /// ### Example
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// FileSystem::ReadResult_t result = fs.readAsync("/Documents/data.txt").get();
+    /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    /// \param path (absolute/relative) to the target file
+    /// \return the future holding the status of the operation and the content of the file
+    std::future<ReadResult_t> readAsync(std::string path);
 };
 
 #endif
\ No newline at end of file
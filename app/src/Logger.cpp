@@ -1,6 +1,8 @@
 #include "Logger.h"
 
 Logger *Logger::instance = NULL;
+thread_local std::ostream *Logger::output = NULL;
+thread_local Logger::Status Logger::lastStatus = Logger::STATUS_FAILED;
 
 Logger *Logger::getInstance() {
     if (instance == NULL)
@@ -8,6 +10,61 @@ Logger *Logger::getInstance() {
     return instance;
 }
 
+std::ostream &Logger::getOutput() {
+    if (output == NULL)
+        return std::cout;
+    return *output;
+}
+
+void Logger::setOutput(std::ostream *stream) {
+    output = stream;
+}
+
+void Logger::alert(Status status) {
+    lastStatus = status;
+    getOutput() << getMessage(status) << "\n";
+}
+
+void Logger::alert(const std::string &msg) {
+    getOutput() << msg << "\n";
+}
+
+std::string Logger::getMessage(Status status) {
+    switch (status) {
+        case STATUS_OK:                       return "OK";
+        case STATUS_FILE_NOT_FOUND:           return "FILE NOT FOUND";
+        case STATUS_PATH_NOT_FOUND:           return "PATH NOT FOUND";
+        case STATUS_EXISTS:                   return "EXISTS";
+        case STATUS_NOT_A_DIRECTORY:          return "TARGET IS NOT A DIRECTORY";
+        case STATUS_NOT_A_FILE:               return "TARGET IS NOT A FILE";
+        case STATUS_NOT_EMPTY:                return "NOT EMPTY";
+        case STATUS_CANNOT_REMOVE_ROOT:       return "CANNOT REMOVE ROOT DIRECTORY";
+        case STATUS_CANNOT_REMOVE_CURRENT:    return "CANNOT REMOVE CURRENT DIRECTORY";
+        case STATUS_CANNOT_MOVE_ROOT:         return "CANNOT MOVE ROOT DIRECTORY";
+        case STATUS_CANNOT_MOVE_INTO_ITSELF:  return "CANNOT MOVE A DIRECTORY INTO ITSELF";
+        case STATUS_CANNOT_COPY_DIRECTORY:    return "CANNOT COPY A DIRECTORY";
+        case STATUS_CANNOT_COPY_INTO_ITSELF:  return "CANNOT COPY A DIRECTORY INTO ITSELF";
+        case STATUS_CANNOT_INCOPY_INTO_FILE:  return "CANNOT IN-COPY INTO A FILE";
+        case STATUS_CANNOT_PRINT_DIRECTORY:   return "CANNOT PRINT OUT DIRECTORY";
+        case STATUS_CANNOT_CREATE_FILE:       return "CANNOT CREATE FILE";
+        case STATUS_INCOMPATIBLE_FILE_SYSTEM: return "INCOMPATIBLE FILE SYSTEM";
+        case STATUS_REPAIRED:                 return "REPAIRED";
+        case STATUS_DEFRAGMENTING:            return "DEFRAGMENTING IN THE BACKGROUND";
+        case STATUS_UNKNOWN_COMMAND:          return "UNKNOWN COMMAND";
+        case STATUS_INVALID_COMMAND:          return "INVALID COMMAND";
+        case STATUS_FAILED:                   return "FAILED";
+    }
+    return "";
+}
+
+Logger::Status Logger::getLastStatus() {
+    return lastStatus;
+}
+
+void Logger::setLastStatus(Status status) {
+    lastStatus = status;
+}
+
 void Logger::log(Type type, std::string msg) {
     switch (type) {
         case ERROR:   log("ERROR",   RED,     msg); break;
@@ -27,7 +84,7 @@ void Logger::log(std::string type, std::string color, std::string msg) {
 #ifdef __unix__
     ss << RESET;
 #endif
-    std::cout << ss.str() << std::endl;
+    Logger::getOutput() << ss.str() << std::endl;
 }
 
 void Logger::testAllTypes() {
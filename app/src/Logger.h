@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <cstdint>
 
 #define ENABLE_LOG_ERROR   ///< enable/disable error logging
 #define ENABLE_LOG_WARNING ///< enable/disable warning logging
@@ -56,9 +57,11 @@
 /// available on coursware. These are, for example,
 /// 'OK', 'FILE NOT FOUND' etc. They were all put in
 /// this macro so the output could be formatted later
-/// on if required.
+/// on if required. The message is either a #Logger::Status
+/// of an operation, which is also recorded as the last status
+/// of the thread, or a string (e.g. 'FORMATTING DISK (5000B)').
 #define USER_ALERT(msg) \
-std::cout << msg << "\n"
+Logger::alert(msg)
 
 /// Formats the number given as a parameter into a three-digit format
 ///
@@ -66,12 +69,12 @@ std::cout << msg << "\n"
 /// and #LOG_INFO to format the number of the line
 /// given as a parameter.
 #define FORMAT_LINE_NUMBER(x) \
-std::cout << "["; \
-if (x < 10) std::cout << "000" << x; \
-else if (x >= 10 && x < 100) std::cout << "00" << x; \
-else if (x >= 100 && x < 1000) std::cout << "0" << x; \
-else std::cout << x; \
-std::cout << "]";
+Logger::getOutput() << "["; \
+if (x < 10) Logger::getOutput() << "000" << x; \
+else if (x >= 10 && x < 100) Logger::getOutput() << "00" << x; \
+else if (x >= 100 && x < 1000) Logger::getOutput() << "0" << x; \
+else Logger::getOutput() << x; \
+Logger::getOutput() << "]";
 
 /// \author A127B0362P silhavyj
 ///
@@ -104,10 +107,42 @@ public:
         WARNING  ///< warning (for example when a path to the file does not exist)
     };
 
+    /// statuses of the operations of the file system (messages for the user)
+    enum Status : uint8_t {
+        STATUS_OK = 0,                       ///< the operation has been performed (OK)
+        STATUS_FILE_NOT_FOUND,               ///< the source file (directory) does not exist (FILE NOT FOUND)
+        STATUS_PATH_NOT_FOUND,               ///< the target path does not exist (PATH NOT FOUND)
+        STATUS_EXISTS,                       ///< there already is an item of the same name (EXISTS)
+        STATUS_NOT_A_DIRECTORY,              ///< the target is expected to be a directory (TARGET IS NOT A DIRECTORY)
+        STATUS_NOT_A_FILE,                   ///< the target is expected to be a file (TARGET IS NOT A FILE)
+        STATUS_NOT_EMPTY,                    ///< the directory is not empty (NOT EMPTY)
+        STATUS_CANNOT_REMOVE_ROOT,           ///< the root directory cannot be removed (CANNOT REMOVE ROOT DIRECTORY)
+        STATUS_CANNOT_REMOVE_CURRENT,        ///< the current directory cannot be removed (CANNOT REMOVE CURRENT DIRECTORY)
+        STATUS_CANNOT_MOVE_ROOT,             ///< the root directory cannot be moved (CANNOT MOVE ROOT DIRECTORY)
+        STATUS_CANNOT_MOVE_INTO_ITSELF,      ///< a directory cannot be moved into its own subtree (CANNOT MOVE A DIRECTORY INTO ITSELF)
+        STATUS_CANNOT_COPY_DIRECTORY,        ///< a directory cannot be copied without -r (CANNOT COPY A DIRECTORY)
+        STATUS_CANNOT_COPY_INTO_ITSELF,      ///< a directory cannot be copied into its own subtree (CANNOT COPY A DIRECTORY INTO ITSELF)
+        STATUS_CANNOT_INCOPY_INTO_FILE,      ///< the target of an import is a file (CANNOT IN-COPY INTO A FILE)
+        STATUS_CANNOT_PRINT_DIRECTORY,       ///< the content of a directory cannot be printed out (CANNOT PRINT OUT DIRECTORY)
+        STATUS_CANNOT_CREATE_FILE,           ///< the disk cannot be created, e.g. it is too small (CANNOT CREATE FILE)
+        STATUS_INCOMPATIBLE_FILE_SYSTEM,     ///< the disk was created by an incompatible version (INCOMPATIBLE FILE SYSTEM)
+        STATUS_REPAIRED,                     ///< the problems found by fsck have been repaired (REPAIRED)
+        STATUS_DEFRAGMENTING,                ///< the defragmentation continues in the background (DEFRAGMENTING IN THE BACKGROUND)
+        STATUS_UNKNOWN_COMMAND,              ///< the command does not exist (UNKNOWN COMMAND)
+        STATUS_INVALID_COMMAND,              ///< the arguments of the command are not valid (INVALID COMMAND)
+        STATUS_FAILED                        ///< the operation has failed without a message for the user (see the log)
+    };
+
 private:
     /// the only instance of this class (singleton pattern)
     static Logger* instance;
 
+    /// stream the output of the current thread goes into (the standard output if it is NULL)
+    static thread_local std::ostream *output;
+
+    /// the last status reported by the current thread (#alert)
+    static thread_local Status lastStatus;
+
 private:
     /// Constructor of the class - creates an instance of it
     ///
@@ -148,6 +183,49 @@ public:
     /// \param msg message that is going to be printed out
     void log(Type type, std::string msg);
 
+    /// Returns the stream the output of the current thread goes into
+    ///
+    /// All the output for the user (messages, listings, logs) goes into this stream.
+    /// It is the standard output unless the thread has set a stream of its own
+    /// (#setOutput), e.g. a thread serving a client of the server.
+    ///
+    /// \return the output stream of the current thread
+    static std::ostream &getOutput();
+
+    /// Sets the stream the output of the current thread goes into
+    ///
+    /// \param stream the output stream (NULL sets the standard output back)
+    static void setOutput(std::ostream *stream);
+
+    /// Prints out the message of the status given as a parameter for the user
+    ///
+    /// The status is also recorded as the last status of the current thread
+    /// (#getLastStatus), so the result of an operation can be told without
+    /// parsing its output.
+    ///
+    /// \param status status of the operation
+    static void alert(Status status);
+
+    /// Prints out a message for the user
+    /// \param msg the message (it is not recorded as a status)
+    static void alert(const std::string &msg);
+
+    /// Returns the message the status given as a parameter is reported by
+    /// \param status status of an operation
+    /// \return the message for the user e.g. 'FILE NOT FOUND'
+    static std::string getMessage(Status status);
+
+    /// Returns the last status reported by the current thread
+    /// \return the last status (#STATUS_FAILED if none has been reported since #setLastStatus)
+    static Status getLastStatus();
+
+    /// Sets the last status of the current thread
+    ///
+    /// It is used to reset the status before an operation is performed.
+    ///
+    /// \param status the new last status
+    static void setLastStatus(Status status);
+
     /// Prints out all the logging types messages.
     ///
     /// The purpose of this method is to show to the user
@@ -0,0 +1,195 @@
+#include "Server.h"
+
+std::atomic<bool> Server::stopping{false};
+
+Server::Server(std::string socketPath, FileSystem *fileSystem, std::function<bool(std::string)> execute) {
+    this->socketPath = socketPath;
+    this->fileSystem = fileSystem;
+    this->execute = execute;
+}
+
+Server::~Server() {
+    if (listeningSocket >= 0) {
+        close(listeningSocket);
+        unlink(socketPath.c_str());
+    }
+    // the clients are disconnected once their current requests are finished
+    for (auto &client : clients)
+        shutdown(client->socket, SHUT_RDWR);
+    for (auto &client : clients) {
+        client->thread.join();
+        close(client->socket);
+    }
+}
+
+bool Server::run() {
+    LOG_INFO("Starting the server");
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.length() >= sizeof(address.sun_path)) {
+        LOG_ERR("The path of the socket is too long");
+        return false;
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+
+    // a socket left behind by a previous run of the server is replaced. Only the owner
+    // may connect since the clients read and write the host files as the server (incp, outcp).
+    // No one can connect before the server listens, so the socket is restricted in time.
+    listeningSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketPath.c_str());
+    if (listeningSocket < 0 || bind(listeningSocket, (sockaddr *)&address, sizeof(address)) != 0 ||
+        chmod(socketPath.c_str(), S_IRUSR | S_IWUSR) != 0 || listen(listeningSocket, SOMAXCONN) != 0) {
+        LOG_ERR("Listening on " + socketPath + " failed");
+        return false;
+    }
+    std::signal(SIGINT, &Server::stop);
+    std::signal(SIGTERM, &Server::stop);
+    std::signal(SIGPIPE, SIG_IGN);
+    USER_ALERT("LISTENING ON " + socketPath);
+
+    while (stopping == false) {
+        removeFinishedClients();
+
+        // use the time while no client is connected
+        // to continue the defragmentation (if there's any)
+        int timeout = DEFRAG_TIME_BUDGET;
+        if (clients.empty() && fileSystem->defragStep())
+            timeout = 0;
+
+        struct pollfd listening = {listeningSocket, POLLIN, 0};
+        if (poll(&listening, 1, timeout) <= 0)
+            continue;
+        int clientSocket = accept(listeningSocket, NULL, NULL);
+        if (clientSocket < 0)
+            continue;
+
+        LOG_INFO("A new client has connected");
+        clients.emplace_back(new Client_t);
+        Client_t *client = clients.back().get();
+        client->socket = clientSocket;
+        client->thread = std::thread(&Server::serveClient, this, client);
+    }
+    USER_ALERT(Logger::STATUS_OK);
+    return true;
+}
+
+void Server::serveClient(Client_t *client) {
+    auto buff = std::unique_ptr<char[]>(new char[SERVER_BUFFER_LEN]);
+    std::string input;
+    std::string output;
+    bool closing = false;
+
+    while (closing == false) {
+        ssize_t n = recv(client->socket, buff.get(), SERVER_BUFFER_LEN, 0);
+        if (n <= 0)
+            break;
+        input.append(buff.get(), n);
+
+        // all the complete requests received so far are
+        // performed before the responses are sent back
+        size_t offset = 0;
+        while (closing == false && input.size() - offset >= REQUEST_HEADER_LEN) {
+            uint32_t size;
+            uint32_t requestId;
+            uint8_t count;
+            memcpy(&size, &input[offset], sizeof(uint32_t));
+            memcpy(&requestId, &input[offset + sizeof(uint32_t)], sizeof(uint32_t));
+            memcpy(&count, &input[offset + 2 * sizeof(uint32_t)], sizeof(uint8_t));
+            if (size > SERVER_MAX_REQUEST_LEN) {
+                addResponse(output, requestId, STATUS_MALFORMED, "");
+                closing = true;
+                break;
+            }
+            if (input.size() - offset - REQUEST_HEADER_LEN < size)
+                break;
+
+            std::string command;
+            if (parseCommand(&input[offset + REQUEST_HEADER_LEN], size, count, command) == false) {
+                addResponse(output, requestId, STATUS_MALFORMED, "");
+                closing = true;
+                break;
+            }
+            std::ostringstream commandOutput;
+            Logger::setOutput(&commandOutput);
+            closing = execute(command);
+            Logger::setOutput(NULL);
+            addResponse(output, requestId, closing ? STATUS_CLOSED : STATUS_DONE, commandOutput.str());
+            offset += REQUEST_HEADER_LEN + size;
+
+            // a long run of pipelined requests does not hold back all the responses
+            if (output.size() >= SERVER_BUFFER_LEN) {
+                if (sendAll(client->socket, output) == false)
+                    closing = true;
+                output.clear();
+            }
+        }
+        input.erase(0, offset);
+        if (sendAll(client->socket, output) == false)
+            break;
+        output.clear();
+    }
+    LOG_INFO("A client has disconnected");
+    fileSystem->closeSession();
+    client->finished = true;
+}
+
+void Server::removeFinishedClients() {
+    for (auto it = clients.begin(); it != clients.end();) {
+        if ((*it)->finished == false) {
+            it++;
+            continue;
+        }
+        (*it)->thread.join();
+        close((*it)->socket);
+        it = clients.erase(it);
+    }
+}
+
+bool Server::parseCommand(const char *data, uint32_t size, uint8_t count, std::string &command) const {
+    uint32_t offset = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t length;
+        if (size - offset < sizeof(uint16_t))
+            return false;
+        memcpy(&length, data + offset, sizeof(uint16_t));
+        offset += sizeof(uint16_t);
+        if (size - offset < length)
+            return false;
+
+        // the command is split up by ' ' by the shell again
+        std::string token(data + offset, length);
+        if (token.empty() || token.find_first_of(" \t\r\n") != std::string::npos)
+            return false;
+        if (i > 0)
+            command += ' ';
+        command += token;
+        offset += length;
+    }
+    return offset == size;
+}
+
+void Server::addResponse(std::string &buffer, uint32_t requestId, Status status, const std::string &output) const {
+    char header[RESPONSE_HEADER_LEN];
+    uint32_t size = output.size();
+    memcpy(header, &size, sizeof(uint32_t));
+    memcpy(header + sizeof(uint32_t), &requestId, sizeof(uint32_t));
+    memcpy(header + 2 * sizeof(uint32_t), &status, sizeof(uint8_t));
+    buffer.append(header, RESPONSE_HEADER_LEN);
+    buffer += output;
+}
+
+bool Server::sendAll(int socket, const std::string &buffer) const {
+    size_t done = 0;
+    while (done < buffer.size()) {
+        ssize_t n = send(socket, buffer.data() + done, buffer.size() - done, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        done += n;
+    }
+    return true;
+}
+
+void Server::stop(int signal) {
+    UNUSED(signal);
+    stopping = true;
+}
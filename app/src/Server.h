@@ -0,0 +1,149 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <string>
+#include <sstream>
+#include <list>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <csignal>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+
+#include "Setup.h"
+#include "Logger.h"
+#include "FileSystem.h"
+
+/// \author A127B0362P silhavyj
+///
+/// This class represents a server keeping the file system mounted and serving
+/// local clients over a Unix domain socket.
+///
+/// Every client is served by a thread of its own, so it has its own current
+/// location within the file system, and the commands of different clients are
+/// performed concurrently. The protocol is binary. A request consists of a header -
+/// the size of the rest of the request (uint32_t), the id of the request (uint32_t),
+/// and the number of tokens of the command (uint8_t) - followed by the tokens, each of
+/// them as its length (uint16_t) and its characters, e.g. ['cp', 'a.txt', 'b.txt'].
+/// A response consists of a header - the size of the rest of the response (uint32_t),
+/// the id of the request (uint32_t), and the status (uint8_t, #Status) - followed by
+/// the output of the command. All the numbers are in the byte order of the machine.
+/// A client does not have to wait for a response before sending another request
+/// (pipelining). The requests of a client are performed in order, and the responses
+/// to all the requests received at once are sent back at once.
+class Server {
+public:
+    /// statuses of the responses
+    enum Status : uint8_t {
+        STATUS_DONE = 0,  ///< the command has been performed
+        STATUS_CLOSED,    ///< the command has been performed and the connection is closed (command exit)
+        STATUS_MALFORMED  ///< the request is malformed and the connection is closed
+    };
+
+    static const size_t REQUEST_HEADER_LEN = 9;  ///< size of the header of a request (B)
+    static const size_t RESPONSE_HEADER_LEN = 9; ///< size of the header of a response (B)
+
+private:
+    /// A client connected to the server
+    struct Client_t {
+        int socket = -1;                   ///< socket of the connection
+        std::thread thread;                ///< thread serving the client
+        std::atomic<bool> finished{false}; ///< flag if the client has disconnected
+    };
+
+    std::string socketPath;                     ///< path to the socket the server listens on
+    FileSystem *fileSystem = NULL;              ///< the file system the commands are performed on
+    std::function<bool(std::string)> execute;   ///< performs a command (returns true if the client wants to close the connection)
+    int listeningSocket = -1;                   ///< socket the clients connect to
+    std::list<std::unique_ptr<Client_t>> clients; ///< clients connected to the server
+
+    /// flag if the server has been asked to stop (SIGINT, SIGTERM). The handler may run on any thread,
+    /// so the flag is a lock-free atomic rather than a volatile sig_atomic_t.
+    static std::atomic<bool> stopping;
+
+public:
+    /// Constructor of the class - creates an instance of it
+    ///
+    /// \param socketPath path to the socket the server is going to listen on
+    /// \param fileSystem the file system the commands are performed on
+    /// \param execute function performing a command, it returns true if the client wants to close the connection
+    Server(std::string socketPath, FileSystem *fileSystem, std::function<bool(std::string)> execute);
+
+    /// Destructor of the class
+    ///
+    /// It disconnects all the clients, waits for their threads
+    /// to be finished, and removes the socket.
+    ~Server();
+
+    /// Copy constructor of the class
+    ///
+    /// It was manually deleted since there is no need to use
+    /// it within this project.
+    Server(const Server &) = delete;
+
+    /// Assignment operator of the class.
+    ///
+    /// It was manually deleted since there is no need to use
+    /// it within this project.
+    void operator=(Server const &) = delete;
+
+    /// Accepts the clients until the server is asked to stop (SIGINT, SIGTERM)
+    ///
+    /// Only the user running the server can connect to the socket (0600).
+    ///
+    /// The time no client is connected is used to continue the
+    /// defragmentation (if there's any).
+    ///
+    /// \return false, if the server cannot listen on the socket. Otherwise, true.
+    bool run();
+
+private:
+    /// Serves a client until it disconnects
+    ///
+    /// It reads the requests of the client, performs all the complete ones, and sends
+    /// the responses back at once. The output of the commands goes into the responses
+    /// (#Logger::setOutput). Once the client disconnects, its session is closed.
+    ///
+    /// \param client the client that is going to be served
+    void serveClient(Client_t *client);
+
+    /// Joins the threads of the clients that have disconnected and closes their sockets
+    void removeFinishedClients();
+
+    /// Parses the tokens of a request into a command
+    ///
+    /// \param data the tokens of the request (the request without its header)
+    /// \param size size of the tokens (B)
+    /// \param count number of tokens
+    /// \param command the command will be stored into it (the tokens separated by ' ')
+    /// \return false, if the tokens do not match their size or a token contains a white space. Otherwise, true.
+    bool parseCommand(const char *data, uint32_t size, uint8_t count, std::string &command) const;
+
+    /// Appends a response at the end of the buffer given as a parameter
+    ///
+    /// \param buffer the buffer of the responses
+    /// \param requestId id of the request the response belongs to
+    /// \param status status of the response
+    /// \param output output of the command
+    void addResponse(std::string &buffer, uint32_t requestId, Status status, const std::string &output) const;
+
+    /// Sends the whole buffer given as a parameter to a client
+    ///
+    /// \param socket socket of the client
+    /// \param buffer the data that is going to be sent
+    /// \return false, if the client has disconnected. Otherwise, true.
+    bool sendAll(int socket, const std::string &buffer) const;
+
+    /// Handles signals SIGINT and SIGTERM by asking the server to stop
+    ///
+    /// \param signal number of the signal
+    static void stop(int signal);
+};
+
+#endif
@@ -12,6 +12,22 @@
 #define CLUSTER_SIZE 1000     ///< size of a cluster (1KB)
 #define INODES_COUNT 100      ///< total number of i-nodes in the file system
 
+#define DEFRAG_TIME_BUDGET 50 ///< time budget of one step of the defragmentation (ms)
+#define DIR_INDEX_MIN_ITEMS 64 ///< number of items of a directory from which the directory gets a hashed index
+#define DENTRY_CACHE_SIZE 4096 ///< maximum number of names cached when resolving paths
+#define INLINE_DATA_LEN 60     ///< maximum size of data stored directly in an i-node (e.g. the path of a symbolic link)
+#define COPY_RUN_LEN 64        ///< maximum number of consecutive clusters copied by one task when copying files in parallel
+#define EXPORT_READ_AHEAD 16   ///< maximum number of files whose clusters are read ahead of the writers when exporting a directory
+#define ALLOCATION_CACHE_LEN 32 ///< maximum number of free clusters a thread reserves ahead of time when allocating clusters
+#define ALLOCATION_GROUP_LEN 8192 ///< number of clusters of an allocation group (a multiple of 64)
+#define READ_AHEAD_MIN_LEN 4      ///< initial (and minimum) number of clusters read ahead when reading a file sequentially
+#define READ_AHEAD_MAX_LEN 256    ///< maximum number of clusters read ahead when reading a file sequentially
+#define READ_AHEAD_WINDOWS 4      ///< maximum number of windows of a file read ahead of the caller when reading the file sequentially
+#define IMPORT_BUFFER_LEN 1048576 ///< size of a buffer the content of an imported file is read into (B)
+#define IMPORT_BUFFER_COUNT 4     ///< number of buffers the content of an imported file is read into ahead of the writer
+#define SERVER_MAX_REQUEST_LEN 65536 ///< maximum size of a request sent to the server (B)
+#define SERVER_BUFFER_LEN 65536      ///< size of the buffers the server reads requests into and collects responses in (B)
+
 #define SIGNATURE "silhavyj"  ///< signature of the owner of the file system
 #define VOLUME_DESCRIPTION "ZOS project - A Simple File System Emulator" ///< a short description of the file system
 
@@ -18,34 +18,55 @@ bool validFORMAT(const std::vector<std::string>& tokens);
 bool validEXIT(const std::vector<std::string>& tokens);
 bool validHELP(const std::vector<std::string>& tokens);
 bool validSLINK(const std::vector<std::string>& tokens);
+bool validFSCK(const std::vector<std::string>& tokens);
+bool validDEFRAG(const std::vector<std::string>& tokens);
+bool validSTATS(const std::vector<std::string>& tokens);
+bool validFIND(const std::vector<std::string>& tokens);
+bool validDU(const std::vector<std::string>& tokens);
 
 bool containsOnlyDigits(std::string str);
 
 Shell::Shell(int argc, char *argv[]) {
     // fill out the table of commands so it can
     // be used for validation, printing out help, and so on
-    commands["cp"]     = {CP,     &validCP,     "cp s1 s2",     "- copies file s1 into file s2"};
-    commands["mv"]     = {MV,     &validMV,     "mv s1 s2",     "- moves file s1 into file s2"};
-    commands["rm"]     = {RM,     &validRM,     "rm s1",        "- removes file s1"};
+    commands["cp"]     = {CP,     &validCP,     "cp [-r] s1 s2", "- copies file s1 into file s2 (-r copies a folder including its content)"};
+    commands["mv"]     = {MV,     &validMV,     "mv s1 s2",     "- moves file/folder s1 into s2"};
+    commands["rm"]     = {RM,     &validRM,     "rm [-r] s1",   "- removes file s1 (-r removes a folder including its content)"};
     commands["mkdir"]  = {MKDIR,  &validMKDIR,  "mkdir a1",     "- creates a new folder a1"};
     commands["rmdir"]  = {RMDIR,  &validRMDIR,  "rmdir a1",     "- removes folder a1"};
     commands["ls"]     = {LS,     &validLS,     "ls a1",        "- prints out the content of folder a1"};
     commands["cat"]    = {CAT,    &validCAT,    "cat s1",       "- prints out the content of file s1"};
     commands["cd"]     = {CD,     &validCD,     "cd a1",        "- changes the current path into folder a1"};
     commands["pwd"]    = {PWD,    &validPWD,    "pwd",          "- prints out the current path"};
-    commands["incp"]   = {INCP,   &validINCP,   "incp s1 s2",   "- load file s1 into the file system (directory s2)"};
-    commands["outcp"]  = {OUTCP,  &validOUTCP,  "outcp s1 s2",  "- exports file s1 out onto the physical disk (directory s2)"};
+    commands["incp"]   = {INCP,   &validINCP,   "incp [-r] s1 s2", "- load file s1 into the file system (directory s2, -r loads a folder including its content)"};
+    commands["outcp"]  = {OUTCP,  &validOUTCP,  "outcp [-r] s1 s2", "- exports file s1 out onto the physical disk (directory s2, -r exports a folder including its content)"};
     commands["info"]   = {INFO,   &validINFO,   "info a1/s1",   "- prints out information about the i-node"};
     commands["load"]   = {LOAD,   &validLOAD,   "load s1",      "- loads commands stored in file s1 and executes them"};
     commands["format"] = {FORMAT, &validFORMAT, "format 600MB", "- formats the file given as a parameter"};
     commands["slink"]  = {SLINK,  &validSLINK,  "slink s1 s2",  "- creates a symbolic link s2 pointing at file s1"};
+    commands["fsck"]   = {FSCK,   &validFSCK,   "fsck [-r]",    "- checks the consistency of the file system (-r repairs it)"};
+    commands["defrag"] = {DEFRAG, &validDEFRAG, "defrag [a1]",  "- defragments files in folder a1 (the whole file system by default)"};
+    commands["stats"]  = {STATS,  &validSTATS,  "stats [a1]",   "- prints out fragmentation and space-usage statistics (files in folder a1)"};
+    commands["frag"]   = {STATS,  &validSTATS,  "frag [a1]",    "- the same as stats"};
+    commands["du"]     = {DU,     &validDU,     "du [a1]",      "- prints out the total size and clusters of folder a1 (the current folder by default)"};
+    commands["find"]   = {FIND,   &validFIND,   "find a1 -name s1", "- finds files/folders matching pattern s1 in folder a1 (-size +n/-n/n filters files by size)"};
     commands["help"]   = {HELP,   &validHELP,   "help",         "- prints out help"};
     commands["exit"]   = {EXIT,   &validEXIT,   "exit",         "- closes the application"};
 
     // test if the user run the program with
     // one parameter which happens to be the
     // name of the file system
-    if (argc != 2)
+    if (argc == 4 && std::string(argv[2]) == "--listen") {
+        // keep the file system mounted and serve the clients
+        // connecting to the socket ('fs data.dat --listen /tmp/fs.sock')
+        std::string diskFileName(argv[1]);
+        fileSystem = new FileSystem(diskFileName);
+        Server server(argv[3], fileSystem, [this](std::string input) {
+            return executeCommand(input);
+        });
+        server.run();
+    }
+    else if (argc != 2)
         std::cout << "You are supposed to run the program with one parameter, which is the name of the file system (e.g. data.dat).\n";
     else {
         // if everything's okay - create a file system
@@ -67,20 +88,32 @@ void Shell::run() {
     while (1) {
         // encourage  the user to enter a command by
         // printing out the input line (pwd>)
-        std::cout << fileSystem->getCurrentPath() << "> ";
+        std::cout << fileSystem->getCurrentPath() << "> " << std::flush;
+
+        // use the time while the user is not typing
+        // to continue the defragmentation (if there's any)
+        while (isInputPending() == false && fileSystem->defragStep())
+            ;
         std::getline(std::cin, input);
         if (executeCommand(input))
             return;
     }
 }
 
+bool Shell::isInputPending() const {
+    if (std::cin.rdbuf()->in_avail() > 0)
+        return true;
+    struct pollfd input = {STDIN_FILENO, POLLIN, 0};
+    return poll(&input, 1, 0) > 0;
+}
+
 void Shell::printHelp() const {
     // print out 'help' for the user
     // in a format so it's easy to read
     for (auto it : commands) {
-        std::cout << std::left << std::setw(15) << std::setfill(' ') << it.second.shortcut;
-        std::cout << std::left << std::setw(15) << std::setfill(' ') << it.second.desc;
-        std::cout << "\n";
+        Logger::getOutput() << std::left << std::setw(18) << std::setfill(' ') << it.second.shortcut;
+        Logger::getOutput() << std::left << std::setw(15) << std::setfill(' ') << it.second.desc;
+        Logger::getOutput() << "\n";
     }
 }
 
@@ -95,12 +128,19 @@ bool Shell::executeCommand(std::string input) {
         return false;
     CMD cmd = getCommand(tokens);
 
+    // a disk created by an incompatible version
+    // can only be formatted before it's used
+    if (fileSystem->isMounted() == false && cmd != INVALID && cmd != UNKNOWN && cmd != EXIT && cmd != HELP && cmd != LOAD && cmd != FORMAT) {
+        USER_ALERT(Logger::STATUS_INCOMPATIBLE_FILE_SYSTEM);
+        return false;
+    }
+
     switch (cmd) {
         case INVALID:
-        USER_ALERT("INVALID COMMAND");
+        USER_ALERT(Logger::STATUS_INVALID_COMMAND);
             break;
         case UNKNOWN:
-        USER_ALERT("UNKNOWN COMMAND");
+        USER_ALERT(Logger::STATUS_UNKNOWN_COMMAND);
             break;
         case EXIT:
             return true;
@@ -115,13 +155,19 @@ bool Shell::executeCommand(std::string input) {
             else fileSystem->ls(tokens[1]);
             break;
         case CP:
-            fileSystem->cp(tokens[1], tokens[2]);
+            // copy a folder including its content ('cp -r /doc /backup')
+            if (tokens.size() == 4)
+                fileSystem->cp(tokens[2], tokens[3], true);
+            else fileSystem->cp(tokens[1], tokens[2]);
             break;
         case MV:
             fileSystem->mv(tokens[1], tokens[2]);
             break;
         case RM:
-            fileSystem->rm(tokens[1]);
+            // remove a folder including its content ('rm -r /doc')
+            if (tokens.size() == 3)
+                fileSystem->rm(tokens[2], true);
+            else fileSystem->rm(tokens[1]);
             break;
         case MKDIR:
             fileSystem->mkdir(tokens[1]);
@@ -139,14 +185,20 @@ bool Shell::executeCommand(std::string input) {
             fileSystem->pwd();
             break;
         case INCP:
+            // import a folder including its content ('incp -r photos /Documents')
+            if (tokens.size() == 4)
+                fileSystem->incpy(tokens[2], tokens[3], true);
             // import to a specific directory e.g. 'incp file.txt /Documents'
-            if (tokens.size() == 3)
+            else if (tokens.size() == 3)
                 fileSystem->incpy(tokens[1], tokens[2]);
             // import to the current directory 'incp file.txt'
             else fileSystem->incpy(tokens[1]);
             break;
         case OUTCP:
-            fileSystem->outcpy(tokens[1], tokens[2]);
+            // export a folder including its content ('outcp -r /Documents backup')
+            if (tokens.size() == 4)
+                fileSystem->outcpy(tokens[2], tokens[3], true);
+            else fileSystem->outcpy(tokens[1], tokens[2]);
             break;
         case INFO:
             fileSystem->info(tokens[1]);
@@ -177,6 +229,34 @@ bool Shell::executeCommand(std::string input) {
         case SLINK:
             fileSystem->slink(tokens[1], tokens[2]);
             break;
+        case DEFRAG:
+            // defragment the whole file system ('defrag')
+            if (tokens.size() == 1)
+                fileSystem->defrag("");
+            // defragment a particular directory ('defrag /videa')
+            else fileSystem->defrag(tokens[1]);
+            break;
+        case STATS:
+            if (tokens.size() == 1)
+                fileSystem->stats("");
+            else fileSystem->stats(tokens[1]);
+            break;
+        case FSCK:
+            // check only ('fsck') or check & repair ('fsck -r')
+            fileSystem->fsck(tokens.size() == 2);
+            break;
+        case DU:
+            if (tokens.size() == 1)
+                fileSystem->du("");
+            else fileSystem->du(tokens[1]);
+            break;
+        case FIND:
+            // find by the name only ('find / -name *.txt')
+            if (tokens.size() == 4)
+                fileSystem->find(tokens[1], tokens[3], "");
+            // find by the name and size ('find / -name *.txt -size +1000')
+            else fileSystem->find(tokens[1], tokens[3], tokens[5]);
+            break;
     }
     return false;
 }
@@ -198,14 +278,14 @@ void Shell::loadFileToExecute(std::string path) {
     if (file.is_open()) {
         std::string line;
         while (std::getline(file, line)) {
-            std::cout << line << "\n";
+            Logger::getOutput() << line << "\n";
             executeCommand(line);
         }
         file.close();
-        USER_ALERT("OK");
+        USER_ALERT(Logger::STATUS_OK);
     }
     else {
-        USER_ALERT("FILE NOT FOUND");
+        USER_ALERT(Logger::STATUS_FILE_NOT_FOUND);
     }
 }
 
@@ -222,7 +302,7 @@ Shell::CMD Shell::getCommand(std::vector<std::string> tokens) {
 }
 
 bool validCP(const std::vector<std::string>& tokens) {
-    return tokens.size() == 3;
+    return tokens.size() == 3 || (tokens.size() == 4 && tokens[1] == "-r");
 }
 
 bool validMV(const std::vector<std::string>& tokens) {
@@ -230,7 +310,7 @@ bool validMV(const std::vector<std::string>& tokens) {
 }
 
 bool validRM(const std::vector<std::string>& tokens) {
-    return tokens.size() == 2;
+    return tokens.size() == 2 || (tokens.size() == 3 && tokens[1] == "-r");
 }
 
 bool validMKDIR(const std::vector<std::string>& tokens) {
@@ -258,11 +338,11 @@ bool validINFO(const std::vector<std::string>& tokens) {
 }
 
 bool validINCP(const std::vector<std::string>& tokens) {
-    return tokens.size() == 3 || tokens.size() == 2;
+    return tokens.size() == 3 || tokens.size() == 2 || (tokens.size() == 4 && tokens[1] == "-r");
 }
 
 bool validOUTCP(const std::vector<std::string>& tokens) {
-    return tokens.size() == 3;
+    return tokens.size() == 3 || (tokens.size() == 4 && tokens[1] == "-r");
 }
 
 bool validLOAD(const std::vector<std::string>& tokens) {
@@ -349,6 +429,33 @@ bool validSLINK(const std::vector<std::string>& tokens) {
     return tokens.size() == 3;
 }
 
+bool validFSCK(const std::vector<std::string>& tokens) {
+    return tokens.size() == 1 || (tokens.size() == 2 && tokens[1] == "-r");
+}
+
+bool validDEFRAG(const std::vector<std::string>& tokens) {
+    return tokens.size() == 1 || tokens.size() == 2;
+}
+
+bool validSTATS(const std::vector<std::string>& tokens) {
+    return tokens.size() == 1 || tokens.size() == 2;
+}
+
+bool validFIND(const std::vector<std::string>& tokens) {
+    if (tokens.size() == 4)
+        return tokens[2] == "-name";
+    if (tokens.size() != 6 || tokens[2] != "-name" || tokens[4] != "-size")
+        return false;
+    std::string size = tokens[5];
+    if (size[0] == '+' || size[0] == '-')
+        size = size.substr(1);
+    return size.empty() == false && size.length() < 19 && containsOnlyDigits(size);
+}
+
+bool validDU(const std::vector<std::string>& tokens) {
+    return tokens.size() == 1 || tokens.size() == 2;
+}
+
 bool containsOnlyDigits(std::string str) {
     for (char c : str)
         if (c < '0' || c > '9')
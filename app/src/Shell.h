@@ -4,9 +4,11 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <poll.h>
 
 #include "Logger.h"
 #include "FileSystem.h"
+#include "Server.h"
 
 /// \author A127B0362P silhavyj
 ///
@@ -36,6 +38,11 @@ private:
         LOAD,    ///< loading a file from the HDD containing commands to perform on the file system
         FORMAT,  ///< formatting a new file system
         SLINK,   ///< creating a symbolic link
+        FSCK,    ///< checking the consistency of the file system
+        DEFRAG,  ///< defragmenting the file system
+        STATS,   ///< printing out fragmentation and space-usage statistics
+        FIND,    ///< finding files and folders by their names
+        DU,      ///< printing out the usage of a directory tree
         HELP,    ///< printing out 'help' for the user
         EXIT,    ///< closes the program
         UNKNOWN, ///< the user entered an unknown command
@@ -69,7 +76,9 @@ public:
     /// the user is supposed to run the program with one parameter only,
     /// which is the name of the file system (e.g. data.dat). If the
     /// user doesn't do so, an alert message will be thrown and the
-    /// program closed.
+    /// program closed. If the name of the file system is followed by '--listen' and
+    /// a path to a socket, the file system will be served to local clients (#Server)
+    /// instead of the user typing commands.
     ///
     /// \param argc number of arguments (argument count)
     /// \param argv arguments themselves (argument values)
@@ -97,6 +106,14 @@ private:
     /// on the file system next. The method terminates when the user enters 'exit'.
     void run();
 
+    /// Returns true if the user has already entered (started entering) another command.
+    ///
+    /// This method is used to find out whether the shell is idle, so it
+    /// could use the time to perform background work such as the defragmentation.
+    ///
+    /// \return true, if there's some input waiting to be read. Otherwise, false.
+    bool isInputPending() const;
+
     /// Splits the string given as a parameter by the character given as a second parameter.
     ///
     /// This method is mainly used when parsing input the user just typed down.
@@ -310,6 +327,56 @@ private:
     /// \return true, if the command if valid. False otherwise.
     friend bool validSLINK(const std::vector<std::string>& tokens);
 
+    /// Tests if the line entered by the user is a valid command #FSCK.
+    ///
+    /// That includes testing such as number of parameters, values of the parameters, etc.
+    /// It does not check if the file, for example, exists though. It will be taken
+    /// care of later in a different part of the program - this is all about syntax.
+    ///
+    /// \param tokens command split up into individual tokens
+    /// \return true, if the command if valid. False otherwise.
+    friend bool validFSCK(const std::vector<std::string>& tokens);
+
+    /// Tests if the line entered by the user is a valid command #DEFRAG.
+    ///
+    /// That includes testing such as number of parameters, values of the parameters, etc.
+    /// It does not check if the file, for example, exists though. It will be taken
+    /// care of later in a different part of the program - this is all about syntax.
+    ///
+    /// \param tokens command split up into individual tokens
+    /// \return true, if the command if valid. False otherwise.
+    friend bool validDEFRAG(const std::vector<std::string>& tokens);
+
+    /// Tests if the line entered by the user is a valid command #STATS.
+    ///
+    /// That includes testing such as number of parameters, values of the parameters, etc.
+    /// It does not check if the file, for example, exists though. It will be taken
+    /// care of later in a different part of the program - this is all about syntax.
+    ///
+    /// \param tokens command split up into individual tokens
+    /// \return true, if the command if valid. False otherwise.
+    friend bool validSTATS(const std::vector<std::string>& tokens);
+
+    /// Tests if the line entered by the user is a valid command #FIND.
+    ///
+    /// That includes testing such as number of parameters, values of the parameters, etc.
+    /// It does not check if the file, for example, exists though. It will be taken
+    /// care of later in a different part of the program - this is all about syntax.
+    ///
+    /// \param tokens command split up into individual tokens
+    /// \return true, if the command if valid. False otherwise.
+    friend bool validFIND(const std::vector<std::string>& tokens);
+
+    /// Tests if the line entered by the user is a valid command #DU.
+    ///
+    /// That includes testing such as number of parameters, values of the parameters, etc.
+    /// It does not check if the file, for example, exists though. It will be taken
+    /// care of later in a different part of the program - this is all about syntax.
+    ///
+    /// \param tokens command split up into individual tokens
+    /// \return true, if the command if valid. False otherwise.
+    friend bool validDU(const std::vector<std::string>& tokens);
+
     /// Tests if the string given as a parameter is consist of digits only.
     /// \param str string in which we want to check if there are only digits (0 - 9) in it.
     /// \return true if the string contains only digits. False otherwise.
@@ -0,0 +1,125 @@
+#include "ThreadPool.h"
+
+thread_local ThreadPool *ThreadPool::currentPool = NULL;
+thread_local size_t ThreadPool::currentWorker = 0;
+
+ThreadPool::ThreadPool(size_t numberOfThreads) {
+    if (numberOfThreads == 0)
+        numberOfThreads = std::thread::hardware_concurrency();
+    if (numberOfThreads == 0)
+        numberOfThreads = 1;
+    for (size_t i = 0; i < numberOfThreads; i++)
+        queues.emplace_back(new WorkerQueue_t);
+    for (size_t i = 0; i < numberOfThreads; i++)
+        workers.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        closing = true;
+    }
+    taskAdded.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void ThreadPool::addTask(std::function<void()> task) {
+    pushTask({std::move(task), NULL});
+}
+
+void ThreadPool::addTask(std::function<void()> task, Batch &batch) {
+    pushTask({std::move(task), &batch});
+}
+
+void ThreadPool::pushTask(Task_t task) {
+    size_t index;
+    if (currentPool == this)
+        index = currentWorker;
+    else {
+        std::unique_lock<std::mutex> lock(mtx);
+        index = nextQueue;
+        nextQueue = (nextQueue + 1) % queues.size();
+    }
+    {
+        std::unique_lock<std::mutex> lock(queues[index]->mtx);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        // the task is counted only once it is in the queue,
+        // so a worker that reserves it will always find it
+        std::unique_lock<std::mutex> lock(mtx);
+        queuedTasks++;
+        unfinishedTasks++;
+        if (task.batch != NULL)
+            task.batch->unfinishedTasks++;
+    }
+    taskAdded.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mtx);
+    tasksFinished.wait(lock, [this]() {
+        return unfinishedTasks == 0;
+    });
+}
+
+void ThreadPool::wait(Batch &batch) {
+    std::unique_lock<std::mutex> lock(mtx);
+    tasksFinished.wait(lock, [&batch]() {
+        return batch.unfinishedTasks == 0;
+    });
+}
+
+size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+ThreadPool::Task_t ThreadPool::takeTask(size_t index) {
+    Task_t task;
+    while (true) {
+        for (size_t i = 0; i < queues.size(); i++) {
+            WorkerQueue_t *queue = queues[(index + i) % queues.size()].get();
+            std::unique_lock<std::mutex> lock(queue->mtx);
+            if (queue->tasks.empty())
+                continue;
+            // the worker's own queue is used as a stack,
+            // the other ones are stolen from as from a queue
+            if (i == 0) {
+                task = std::move(queue->tasks.back());
+                queue->tasks.pop_back();
+            } else {
+                task = std::move(queue->tasks.front());
+                queue->tasks.pop_front();
+            }
+            return task;
+        }
+    }
+}
+
+void ThreadPool::work(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+    while (true) {
+        {
+            // wait for a task (or for the pool to be closed)
+            std::unique_lock<std::mutex> lock(mtx);
+            taskAdded.wait(lock, [this]() {
+                return closing || queuedTasks > 0;
+            });
+            if (queuedTasks == 0)
+                return;
+            queuedTasks--;
+        }
+        Task_t task = takeTask(index);
+        task.function();
+        {
+            // the callers waiting for different batches share the condition variable
+            std::unique_lock<std::mutex> lock(mtx);
+            bool batchFinished = task.batch != NULL && --task.batch->unfinishedTasks == 0;
+            if (--unfinishedTasks == 0 || batchFinished)
+                tasksFinished.notify_all();
+        }
+    }
+}
@@ -0,0 +1,154 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/// \author A127B0362P silhavyj
+///
+/// This class represents a simple pool of worker threads.
+///
+/// It is used by the parts of the file system that can split their work
+/// up into independent tasks, such as checking the consistency of the
+/// file system (a range of i-nodes per task). Every worker has its own queue
+/// of tasks. A task added by a worker (e.g. a subdirectory found while walking
+/// a directory tree) goes into the queue of that worker, which takes its newest
+/// tasks first. A worker whose queue is empty steals the oldest task from the
+/// queues of the other workers.
+///
+/// The pool is meant to be long-lived and shared by several callers. A caller
+/// adds its tasks as a batch (#Batch) and waits only for the tasks of its own
+/// batch (including the ones added by the tasks themselves). A task must not
+/// wait for a batch of the same pool, as it would hold up one of the workers.
+class ThreadPool {
+public:
+    /// A group of tasks a caller can wait for (#wait)
+    class Batch {
+    private:
+        friend class ThreadPool;
+        size_t unfinishedTasks = 0; ///< number of tasks of the batch that have not been finished yet (guarded by the pool)
+
+    public:
+        /// Constructor of the class - creates an empty batch
+        Batch() = default;
+
+        /// Copy constructor of the class - deleted since the tasks refer to the batch
+        Batch(const Batch &) = delete;
+
+        /// Assignment operator of the class - deleted since the tasks refer to the batch
+        void operator=(Batch const &) = delete;
+    };
+
+private:
+    /// A task waiting to be executed
+    struct Task_t {
+        std::function<void()> function; ///< the work itself
+        Batch *batch;                   ///< batch the task belongs to (NULL if it does not belong to any)
+    };
+
+    /// A queue of tasks of one worker
+    struct WorkerQueue_t {
+        std::deque<Task_t> tasks; ///< tasks waiting to be executed
+        std::mutex mtx;           ///< mutex guarding the queue
+    };
+
+    std::vector<std::thread> workers;                    ///< worker threads of the pool
+    std::vector<std::unique_ptr<WorkerQueue_t>> queues;  ///< queues of tasks (one per worker)
+    std::mutex mtx;                                      ///< mutex guarding the counters of tasks
+    std::condition_variable taskAdded;                   ///< notifies the workers that there's a new task (or the pool is being closed)
+    std::condition_variable tasksFinished;               ///< notifies the callers that all tasks (of a batch) have been finished
+    size_t queuedTasks = 0;                              ///< number of tasks not taken by any worker yet
+    size_t unfinishedTasks = 0;                          ///< number of tasks that have not been finished yet
+    size_t nextQueue = 0;                                ///< queue the next task added from outside of the pool goes into
+    bool closing = false;                                ///< flag if the pool is being closed
+
+    static thread_local ThreadPool *currentPool; ///< pool the current thread works for (NULL if it is not a worker)
+    static thread_local size_t currentWorker;    ///< index of the worker within its pool
+
+public:
+    /// Constructor of the class - creates an instance of it
+    ///
+    /// If the number of threads is 0, the number of threads
+    /// will be the same as the number of cores of the machine.
+    ///
+    /// \param numberOfThreads number of worker threads
+    ThreadPool(size_t numberOfThreads = 0);
+
+    /// Destructor of the class
+    ///
+    /// It waits for all the tasks to be finished
+    /// and joins all the worker threads.
+    ~ThreadPool();
+
+    /// Copy constructor of the class
+    ///
+    /// It was manually deleted since there is no need to use
+    /// it within this project.
+    ThreadPool(const ThreadPool &) = delete;
+
+    /// Assignment operator of the class.
+    ///
+    /// It was manually deleted since there is no need to use
+    /// it within this project.
+    void operator=(ThreadPool const &) = delete;
+
+    /// Adds a new task into the pool
+    ///
+    /// If it is called by a worker of the pool, the task goes into the queue
+    /// of that worker. Otherwise, the tasks are spread over the queues evenly.
+    ///
+    /// \param task task that is going to be executed by one of the workers
+    void addTask(std::function<void()> task);
+
+    /// Adds a new task of a batch into the pool (see #addTask)
+    ///
+    /// \param task task that is going to be executed by one of the workers
+    /// \param batch batch the task belongs to (it must outlive the task)
+    void addTask(std::function<void()> task, Batch &batch);
+
+    /// Waits until all the tasks (including the ones added by the tasks themselves) have been finished
+    void wait();
+
+    /// Waits until all the tasks of the batch given as a parameter have been finished
+    ///
+    /// The tasks of the other batches may still be running.
+    ///
+    /// \param batch the batch
+    void wait(Batch &batch);
+
+    /// Returns the number of worker threads of the pool
+    /// \return number of worker threads
+    size_t size() const;
+
+private:
+    /// Puts the task given as a parameter into one of the queues (see #addTask)
+    /// \param task the task
+    void pushTask(Task_t task);
+
+    /// The main loop of a worker thread
+    ///
+    /// The worker takes a task (#takeTask) and executes it.
+    /// If there is no task in the pool, it waits until a new
+    /// one is added or the pool is closed.
+    ///
+    /// \param index index of the worker
+    void work(size_t index);
+
+    /// Takes a task out of the queues
+    ///
+    /// It takes the newest task of the worker's own queue. If the queue
+    /// is empty, the oldest task of another worker's queue is stolen.
+    /// The caller must have reserved the task in #queuedTasks, so there
+    /// is always one to be found.
+    ///
+    /// \param index index of the worker
+    /// \return the task taken out of the queues
+    Task_t takeTask(size_t index);
+};
+
+#endif
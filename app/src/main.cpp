@@ -5,7 +5,10 @@
 /// The program is supposed to be run with only one
 /// parameter, which is the name of the file system e.g. 'data.dat'.
 /// If the user doesn't do so, an alert message will be thrown into
-/// the terminal and the application closed.
+/// the terminal and the application closed. The name of the file system
+/// can be followed by '--listen' and a path to a socket, e.g.
+/// 'data.dat --listen /tmp/fs.sock', in which case the file system
+/// is served to local clients over the socket.
 ///
 /// \param argc number of arguments passed on from the terminal
 /// \param argv values of all the arguments
@@ -0,0 +1,191 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <unistd.h>
+
+#include "Disk.h"
+
+/// \author A127B0362P silhavyj
+///
+/// A test of the allocation of clusters under contention.
+///
+/// Many threads allocate and release clusters at the same time. Every allocated
+/// cluster is marked as taken, so a cluster handed out to two threads at once is
+/// caught. The threads also exhaust the disk together, which must give them exactly
+/// as many clusters as a single thread gets, and no cluster may be lost once all of
+/// them have been released.
+
+#define TEST_DISK_FILE   "alloc.dat" ///< storage of the file system used by the test
+#define TEST_DISK_SIZE   20000000    ///< size of the disk used by the test (20MB)
+#define TEST_ALLOCATIONS 100000      ///< number of clusters allocated by every thread
+#define TEST_BATCH       64          ///< number of clusters a thread holds before it releases them
+
+static std::unique_ptr<std::atomic<bool>[]> taken; ///< flags if the clusters are held by a thread
+
+static int failures = 0; ///< number of checks that have failed
+
+/// Prints out the result of a check
+///
+/// \param name name of the check
+/// \param passed flag if the check has passed
+static void check(std::string name, bool passed) {
+    std::cout << name << (passed ? " OK" : " FAILED") << "\n";
+    if (passed == false)
+        failures++;
+}
+
+/// Marks the clusters as taken
+///
+/// \param clusters indexes of the clusters
+/// \return false, if some of the clusters has already been taken. Otherwise, true.
+static bool take(const std::vector<int32_t> &clusters) {
+    bool valid = true;
+    for (int32_t cluster : clusters)
+        valid &= cluster >= 0 && cluster < TEST_DISK_SIZE / CLUSTER_SIZE && taken[cluster].exchange(true) == false;
+    return valid;
+}
+
+/// Marks the clusters as not taken and releases them
+///
+/// \param disk the disk the clusters were allocated on
+/// \param clusters indexes of the clusters
+static void release(Disk *disk, std::vector<int32_t> &clusters) {
+    for (int32_t cluster : clusters)
+        taken[cluster] = false;
+    disk->releaseClusters(clusters);
+    clusters.clear();
+}
+
+/// Allocates and releases clusters until the thread has allocated #TEST_ALLOCATIONS of them
+///
+/// \param disk the disk the clusters are allocated on
+/// \return false, if a cluster has been allocated twice or the disk has run out of free clusters. Otherwise, true.
+static bool allocateClusters(Disk *disk) {
+    std::vector<int32_t> clusters;
+    for (int32_t allocated = 0; allocated < TEST_ALLOCATIONS;) {
+        // every other allocation claims a few clusters at once
+        std::vector<int32_t> newClusters;
+        if (allocated % 2 == 0)
+            newClusters = disk->getFreeClusters(8);
+        else newClusters.push_back(disk->getFreeCluster());
+        if (newClusters.empty() || take(newClusters) == false)
+            return false;
+        clusters.insert(clusters.end(), newClusters.begin(), newClusters.end());
+        allocated += newClusters.size();
+        if (clusters.size() >= TEST_BATCH)
+            release(disk, clusters);
+    }
+    release(disk, clusters);
+    return true;
+}
+
+/// Allocates clusters until the disk runs out of free clusters
+///
+/// \param disk the disk the clusters are allocated on
+/// \param clusters the allocated clusters will be stored into it
+/// \return false, if a cluster has been allocated twice. Otherwise, true.
+static bool exhaustClusters(Disk *disk, std::vector<int32_t> &clusters) {
+    // a few clusters at once while there are enough of them
+    while (true) {
+        std::vector<int32_t> newClusters = disk->getFreeClusters(8);
+        if (newClusters.empty())
+            break;
+        if (take(newClusters) == false)
+            return false;
+        clusters.insert(clusters.end(), newClusters.begin(), newClusters.end());
+    }
+    // and the rest of them one by one
+    for (int32_t cluster = disk->getFreeCluster(); cluster != disk->NULL_POINTER; cluster = disk->getFreeCluster()) {
+        if (take({cluster}) == false)
+            return false;
+        clusters.push_back(cluster);
+    }
+    return true;
+}
+
+/// Exhausts the disk by the number of threads given as a parameter
+///
+/// \param disk the disk the clusters are allocated on
+/// \param numberOfThreads number of threads allocating the clusters
+/// \param clusters the clusters allocated by every thread will be stored into it
+/// \return false, if a cluster has been allocated twice. Otherwise, true.
+static bool exhaustClusters(Disk *disk, size_t numberOfThreads, std::vector<std::vector<int32_t>> &clusters) {
+    std::vector<std::thread> threads;
+    std::vector<char> results(numberOfThreads, false);
+    clusters.assign(numberOfThreads, {});
+    for (size_t i = 0; i < numberOfThreads; i++)
+        threads.emplace_back([disk, &clusters, &results, i]() {
+            results[i] = exhaustClusters(disk, clusters[i]);
+        });
+    for (auto &thread : threads)
+        thread.join();
+    for (char result : results)
+        if (result == false)
+            return false;
+    return true;
+}
+
+/// Returns the total number of clusters held by the threads
+///
+/// \param clusters the clusters held by every thread
+/// \return the total number of clusters
+static size_t countClusters(const std::vector<std::vector<int32_t>> &clusters) {
+    size_t count = 0;
+    for (auto &threadClusters : clusters)
+        count += threadClusters.size();
+    return count;
+}
+
+int main() {
+    unlink(TEST_DISK_FILE);
+    taken.reset(new std::atomic<bool>[TEST_DISK_SIZE / CLUSTER_SIZE]());
+    size_t numberOfThreads = std::max(8u, std::thread::hardware_concurrency());
+    {
+        Disk disk(TEST_DISK_FILE);
+        disk.format(TEST_DISK_SIZE);
+
+        // the number of free clusters a single thread gets
+        std::vector<std::vector<int32_t>> clusters;
+        check("exhaust", exhaustClusters(&disk, 1, clusters));
+        size_t freeClusters = countClusters(clusters);
+        release(&disk, clusters[0]);
+
+        // the threads allocate and release clusters at the same time
+        std::vector<std::thread> threads;
+        std::vector<char> results(numberOfThreads, false);
+        for (size_t i = 0; i < numberOfThreads; i++)
+            threads.emplace_back([&disk, &results, i]() {
+                results[i] = allocateClusters(&disk);
+            });
+        for (auto &thread : threads)
+            thread.join();
+        bool allocated = true;
+        for (char result : results)
+            allocated &= result;
+        check("contention", allocated);
+
+        // together, the threads get all the free clusters, each of them only once
+        check("parallel exhaust", exhaustClusters(&disk, numberOfThreads, clusters) && countClusters(clusters) == freeClusters);
+        threads.clear();
+        for (size_t i = 0; i < numberOfThreads; i++)
+            threads.emplace_back([&disk, &clusters, i]() {
+                release(&disk, clusters[i]);
+            });
+        for (auto &thread : threads)
+            thread.join();
+
+        // no cluster has been lost
+        check("release", exhaustClusters(&disk, 1, clusters) && countClusters(clusters) == freeClusters);
+        release(&disk, clusters[0]);
+
+        Logger::setLastStatus(Logger::STATUS_FAILED);
+        disk.checkFileSystem(false);
+        check("fsck", Logger::getLastStatus() == Logger::STATUS_OK);
+    }
+    unlink(TEST_DISK_FILE);
+    return failures == 0 ? 0 : 1;
+}
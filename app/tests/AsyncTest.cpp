@@ -0,0 +1,101 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <future>
+#include <unistd.h>
+
+#include "FileSystem.h"
+
+/// \author A127B0362P silhavyj
+///
+/// A test of the asynchronous API of the file system (#FileSystem).
+///
+/// The operations are started from the main thread and performed by the executor.
+/// The test checks the statuses they report, the content of the files they copy,
+/// the operations started in parallel, and that an operation works with the current
+/// location of the thread that has started it.
+
+#define TEST_DISK_FILE   "async.dat"             ///< storage of the file system used by the test
+#define TEST_INPUT_FILE  "tests/input/test.txt"  ///< file imported into the file system
+#define TEST_OUTPUT_FILE "async.out"             ///< file the content is exported into
+#define TEST_FILES       16                      ///< number of files imported in parallel
+
+static int failures = 0; ///< number of checks that have failed
+
+/// Prints out the result of a check
+///
+/// \param name name of the check
+/// \param passed flag if the check has passed
+static void check(std::string name, bool passed) {
+    std::cout << name << (passed ? " OK" : " FAILED") << "\n";
+    if (passed == false)
+        failures++;
+}
+
+/// Reads the whole content of a file on the physical disk
+///
+/// \param fileName name of the file
+/// \return the content of the file
+static std::string readFile(std::string fileName) {
+    std::ifstream file(fileName, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+int main() {
+    unlink(TEST_DISK_FILE);
+    std::string original = readFile(TEST_INPUT_FILE);
+    {
+        FileSystem fs(TEST_DISK_FILE);
+
+        check("mkdir", fs.mkdirAsync("/docs").get() == Logger::STATUS_OK);
+        check("mkdir existing", fs.mkdirAsync("/docs").get() == Logger::STATUS_EXISTS);
+        check("incp", fs.incpyAsync(TEST_INPUT_FILE, "/docs/test.txt").get() == Logger::STATUS_OK);
+
+        FileSystem::ReadResult_t result = fs.readAsync("/docs/test.txt").get();
+        check("read", result.status == Logger::STATUS_OK && result.content == original);
+        result = fs.readAsync("/docs/missing.txt").get();
+        check("read missing", result.status == Logger::STATUS_FILE_NOT_FOUND && result.content.empty());
+
+        // the relative paths are resolved against the location of the caller
+        fs.cd("/docs");
+        check("cp", fs.cpAsync("test.txt", "copy.txt").get() == Logger::STATUS_OK);
+        check("mv", fs.mvAsync("copy.txt", "/moved.txt").get() == Logger::STATUS_OK);
+        check("outcp", fs.outcpyAsync("/moved.txt", TEST_OUTPUT_FILE).get() == Logger::STATUS_OK && readFile(TEST_OUTPUT_FILE) == original);
+
+        // the operation works with the current location of the caller, not the one of the executor
+        fs.mkdirAsync("/docs/sub").get();
+        fs.cd("/docs/sub");
+        check("rm current", fs.rmAsync("/docs/sub", true).get() == Logger::STATUS_CANNOT_REMOVE_CURRENT);
+        fs.cd("/");
+        check("rm", fs.rmAsync("/docs/sub", true).get() == Logger::STATUS_OK);
+
+        // the operations started at once are performed in parallel
+        std::vector<std::future<Logger::Status>> imports;
+        for (int i = 0; i < TEST_FILES; i++)
+            imports.push_back(fs.incpyAsync(TEST_INPUT_FILE, "/docs/file" + std::to_string(i)));
+        bool imported = true;
+        for (auto &status : imports)
+            imported &= status.get() == Logger::STATUS_OK;
+        std::vector<std::future<FileSystem::ReadResult_t>> reads;
+        for (int i = 0; i < TEST_FILES; i++)
+            reads.push_back(fs.readAsync("/docs/file" + std::to_string(i)));
+        for (auto &read : reads)
+            imported &= read.get().content == original;
+        check("parallel", imported);
+
+        std::vector<std::future<Logger::Status>> removals;
+        for (int i = 0; i < TEST_FILES; i++)
+            removals.push_back(fs.rmAsync("/docs/file" + std::to_string(i)));
+        bool removed = true;
+        for (auto &status : removals)
+            removed &= status.get() == Logger::STATUS_OK;
+        check("parallel rm", removed && fs.rmAsync("/docs", true).get() == Logger::STATUS_OK);
+    }
+    unlink(TEST_OUTPUT_FILE);
+    unlink(TEST_DISK_FILE);
+    return failures == 0 ? 0 : 1;
+}
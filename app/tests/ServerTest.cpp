@@ -0,0 +1,231 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "Shell.h"
+
+/// \author A127B0362P silhavyj
+///
+/// A test of the server mode (#Server).
+///
+/// The shell serves a fresh file system over a Unix domain socket in a thread of
+/// its own, and the test connects to it as clients speaking the binary protocol.
+/// It checks the responses of single and pipelined requests, the sessions of
+/// concurrent clients, the malformed requests, and closing the connection.
+
+#define TEST_DISK_FILE   "server.dat"  ///< storage of the file system used by the test
+#define TEST_SOCKET_FILE "server.sock" ///< socket the server listens on
+#define TEST_TIMEOUT     5000          ///< time to wait for the server to start listening (ms)
+
+/// A response of the server
+struct Response_t {
+    uint32_t requestId = 0;                      ///< id of the request the response belongs to
+    Server::Status status = Server::STATUS_DONE; ///< status of the response
+    std::string output;                          ///< output of the command
+};
+
+static int failures = 0; ///< number of checks that have failed
+
+/// Prints out the result of a check
+///
+/// \param name name of the check
+/// \param passed flag if the check has passed
+static void check(std::string name, bool passed) {
+    std::cout << name << (passed ? " OK" : " FAILED") << "\n";
+    if (passed == false)
+        failures++;
+}
+
+/// Connects to the server
+///
+/// It keeps trying until the server starts listening or #TEST_TIMEOUT runs out.
+///
+/// \return socket of the connection (-1 if the server is not listening)
+static int connectToServer() {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, TEST_SOCKET_FILE);
+    for (int waited = 0; waited < TEST_TIMEOUT; waited += 10) {
+        int clientSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(clientSocket, (sockaddr *)&address, sizeof(address)) == 0)
+            return clientSocket;
+        close(clientSocket);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return -1;
+}
+
+/// Puts a request together
+///
+/// \param requestId id of the request
+/// \param tokens tokens of the command
+/// \return the request (header followed by the tokens)
+static std::string createRequest(uint32_t requestId, const std::vector<std::string> &tokens) {
+    std::string body;
+    for (auto &token : tokens) {
+        uint16_t length = token.length();
+        body.append((const char *)&length, sizeof(uint16_t));
+        body += token;
+    }
+    uint32_t size = body.size();
+    uint8_t count = tokens.size();
+    std::string request;
+    request.append((const char *)&size, sizeof(uint32_t));
+    request.append((const char *)&requestId, sizeof(uint32_t));
+    request.append((const char *)&count, sizeof(uint8_t));
+    return request + body;
+}
+
+/// Sends the whole buffer given as a parameter to the server
+///
+/// \param clientSocket socket of the connection
+/// \param data the data that is going to be sent
+/// \return false, if the server has disconnected. Otherwise, true.
+static bool sendAll(int clientSocket, const std::string &data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = send(clientSocket, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        done += n;
+    }
+    return true;
+}
+
+/// Receives exactly the given number of bytes from the server
+///
+/// \param clientSocket socket of the connection
+/// \param size number of bytes to be received
+/// \param data the data will be stored into it
+/// \return false, if the server has disconnected before sending all of them. Otherwise, true.
+static bool receiveAll(int clientSocket, size_t size, std::string &data) {
+    data.resize(size);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = recv(clientSocket, &data[done], size - done, 0);
+        if (n <= 0)
+            return false;
+        done += n;
+    }
+    return true;
+}
+
+/// Receives a response from the server
+///
+/// \param clientSocket socket of the connection
+/// \param response the response will be stored into it
+/// \return false, if the server has disconnected. Otherwise, true.
+static bool receiveResponse(int clientSocket, Response_t &response) {
+    std::string header;
+    if (receiveAll(clientSocket, Server::RESPONSE_HEADER_LEN, header) == false)
+        return false;
+    uint32_t size;
+    memcpy(&size, &header[0], sizeof(uint32_t));
+    memcpy(&response.requestId, &header[sizeof(uint32_t)], sizeof(uint32_t));
+    memcpy(&response.status, &header[2 * sizeof(uint32_t)], sizeof(uint8_t));
+    return receiveAll(clientSocket, size, response.output);
+}
+
+/// Sends a request to the server and receives the response to it
+///
+/// \param clientSocket socket of the connection
+/// \param requestId id of the request
+/// \param tokens tokens of the command
+/// \return the response (with an empty output and #Server::STATUS_MALFORMED if the server has disconnected)
+static Response_t perform(int clientSocket, uint32_t requestId, const std::vector<std::string> &tokens) {
+    Response_t response;
+    if (sendAll(clientSocket, createRequest(requestId, tokens)) == false || receiveResponse(clientSocket, response) == false)
+        response.status = Server::STATUS_MALFORMED;
+    return response;
+}
+
+/// Returns true if the server has closed the connection
+///
+/// \param clientSocket socket of the connection
+/// \return true, if the server has closed the connection. Otherwise, false.
+static bool isClosed(int clientSocket) {
+    char c;
+    return recv(clientSocket, &c, sizeof(char), 0) <= 0;
+}
+
+int main() {
+    unlink(TEST_DISK_FILE);
+    std::thread serverThread([]() {
+        char *argv[] = {(char *)"fs", (char *)TEST_DISK_FILE, (char *)"--listen", (char *)TEST_SOCKET_FILE, NULL};
+        Shell shell(4, argv);
+    });
+
+    int first = connectToServer();
+    if (first < 0) {
+        std::cout << "The server is not listening on " << TEST_SOCKET_FILE << "\n";
+        std::raise(SIGTERM);
+        serverThread.join();
+        unlink(TEST_DISK_FILE);
+        return 1;
+    }
+
+    // a single request
+    Response_t response = perform(first, 1, {"mkdir", "/docs"});
+    check("request", response.requestId == 1 && response.status == Server::STATUS_DONE && response.output == "OK\n");
+
+    // pipelined requests are performed in order, each of them gets its own response
+    std::string requests = createRequest(2, {"cd", "/docs"}) + createRequest(3, {"mkdir", "notes"}) + createRequest(4, {"pwd"});
+    sendAll(first, requests);
+    bool inOrder = true;
+    for (uint32_t requestId = 2; requestId <= 4; requestId++)
+        inOrder &= receiveResponse(first, response) && response.requestId == requestId && response.status == Server::STATUS_DONE;
+    check("pipelining", inOrder && response.output == "/docs/\n");
+
+    // every client has its own current location
+    int second = connectToServer();
+    response = perform(second, 1, {"pwd"});
+    check("sessions", response.output == "/\n" && perform(first, 5, {"pwd"}).output == "/docs/\n");
+
+    // clients are served concurrently
+    std::vector<std::thread> clients;
+    std::vector<char> results(4, false);
+    for (size_t i = 0; i < results.size(); i++)
+        clients.emplace_back([&results, i]() {
+            int clientSocket = connectToServer();
+            std::string name = "/docs/client" + std::to_string(i);
+            results[i] = perform(clientSocket, 1, {"mkdir", name}).output == "OK\n" &&
+                         perform(clientSocket, 2, {"cd", name}).output == "OK\n" &&
+                         perform(clientSocket, 3, {"pwd"}).output == name + "/\n";
+            close(clientSocket);
+        });
+    for (auto &client : clients)
+        client.join();
+    bool concurrent = true;
+    for (char result : results)
+        concurrent &= result;
+    check("concurrent clients", concurrent && perform(second, 2, {"fsck"}).output == "OK\n");
+
+    // a token containing a white space is malformed, the connection gets closed
+    response = perform(second, 3, {"mkdir", "a b"});
+    check("malformed token", response.requestId == 3 && response.status == Server::STATUS_MALFORMED && isClosed(second));
+    close(second);
+
+    // so is a request exceeding the maximum size
+    second = connectToServer();
+    uint32_t header[2] = {SERVER_MAX_REQUEST_LEN + 1, 1};
+    sendAll(second, std::string((const char *)header, sizeof(header)) + '\1');
+    check("oversized request", receiveResponse(second, response) && response.status == Server::STATUS_MALFORMED && isClosed(second));
+    close(second);
+
+    // command exit closes the connection
+    response = perform(first, 6, {"exit"});
+    check("exit", response.requestId == 6 && response.status == Server::STATUS_CLOSED && isClosed(first));
+    close(first);
+
+    std::raise(SIGTERM);
+    serverThread.join();
+    unlink(TEST_DISK_FILE);
+    return failures == 0 ? 0 : 1;
+}